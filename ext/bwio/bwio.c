@@ -8,6 +8,8 @@
 #include <ts7200.h>
 #include "bwio.h"
 
+#if NLOCAL
+
 /*
  * The UARTs are initialized by RedBoot to the following state
  * 	115,200 bps
@@ -83,6 +85,37 @@ int bwputc( int channel, char c ) {
 	return 0;
 }
 
+#else
+
+#include <stdio.h>
+
+/*
+ * Local builds have no UARTs to busy-wait on.
+ * COM2 is the terminal, so route it through stdio and drop COM1.
+ */
+int bwsetfifo( int channel, int state ) {
+	return ( channel == COM1 || channel == COM2 ) ? 0 : -1;
+}
+
+int bwsetspeed( int channel, int speed ) {
+	return ( channel == COM1 || channel == COM2 ) ? 0 : -1;
+}
+
+int bwputc( int channel, char c ) {
+	switch( channel ) {
+	case COM1:
+		return 0;
+	case COM2:
+		putchar( c );
+		fflush( stdout );
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+#endif
+
 char c2x( char ch ) {
 	if ( (ch <= 9) ) return '0' + ch;
 	return 'a' + ch - 10;
@@ -122,6 +155,7 @@ void bwputw( int channel, int n, char fc, char *bf ) {
 	while( ( ch = *bf++ ) ) bwputc( channel, ch );
 }
 
+#if NLOCAL
 int bwgetc( int channel ) {
 	int *flags, *data;
 	unsigned char c;
@@ -143,6 +177,18 @@ int bwgetc( int channel ) {
 	c = *data;
 	return c;
 }
+#else
+int bwgetc( int channel ) {
+	switch( channel ) {
+	case COM1:
+		return -1;
+	case COM2:
+		return getchar( );
+	default:
+		return -1;
+	}
+}
+#endif
 
 int bwa2d( char ch ) {
 	if( ch >= '0' && ch <= '9' ) return ch - '0';
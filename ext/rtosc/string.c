@@ -350,19 +350,22 @@ RtStrIsWhitespace
     return TRUE;
 }
 
+// Words moved per iteration of the block loops
+#define RT_MEM_BLOCK_WORDS 8
+
+// Anything shorter than this is not worth aligning
+#define RT_MEM_MIN_BLOCK_BYTES (2 * sizeof(UINT))
+
 static
 inline
 VOID
-RtMemcpypUnaligned
+RtMemcpypBytes
     (
-        PVOID dest, 
-        PVOID src, 
+        CHAR* d,
+        CHAR* s,
         UINT bytes
     )
 {
-    CHAR* d = dest;
-    CHAR* s = src;
-
     while(bytes > 0)
     {
         *(d++) = *(s++);
@@ -373,24 +376,100 @@ RtMemcpypUnaligned
 static
 inline
 VOID
-RtMemcpypAligned
+RtMemcpypWords
     (
-        PVOID dest, 
-        PVOID src, 
-        UINT bytes
+        UINT* d,
+        UINT* s,
+        UINT words
     )
 {
-    INT* d = dest;
-    INT* s = src;
-    UINT words = bytes / sizeof(INT);
+    UINT blocks = words / RT_MEM_BLOCK_WORDS;
+
+    if(blocks > 0)
+    {
+#if NLOCAL
+        // Two 4 register bursts per block.  r9 and r10 belong to -fPIC
+        // and fp to the apcs frame, so stay within r3-r6.
+        asm volatile("1:\n\t"
+                     "ldmia %1!, {r3-r6}\n\t"
+                     "stmia %0!, {r3-r6}\n\t"
+                     "ldmia %1!, {r3-r6}\n\t"
+                     "stmia %0!, {r3-r6}\n\t"
+                     "subs %2, %2, #1\n\t"
+                     "bne 1b"
+                     : "+r" (d), "+r" (s), "+r" (blocks)
+                     :
+                     : "r3", "r4", "r5", "r6", "cc", "memory");
+#else
+        while(blocks > 0)
+        {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = s[3];
+            d[4] = s[4];
+            d[5] = s[5];
+            d[6] = s[6];
+            d[7] = s[7];
+
+            d += RT_MEM_BLOCK_WORDS;
+            s += RT_MEM_BLOCK_WORDS;
+            blocks--;
+        }
+#endif
+    }
+
+    words = words % RT_MEM_BLOCK_WORDS;
 
     while(words > 0)
     {
         *(d++) = *(s++);
         words--;
     }
+}
+
+static
+inline
+VOID
+RtMemcpypShiftedWords
+    (
+        UINT* d,
+        CHAR* s,
+        UINT words
+    )
+{
+    // The source is not word aligned, but the destination is.
+    // Read aligned source words and stitch neighbours together
+    // (little endian) so every store is still a full word.
+    UINT offset = ((UINTPTR) s) % sizeof(UINT);
+    UINT shift = offset * 8;
+    UINT* ws = (UINT*) (s - offset);
+    UINT current = *(ws++);
+
+    while(words > 1)
+    {
+        UINT next = *(ws++);
+
+        *(d++) = (current >> shift) | (next << (32 - shift));
+        current = next;
+        words--;
+    }
+
+    if(words > 0)
+    {
+        // The next aligned word runs past the end of the source.
+        // Only read the bytes that belong to the last word.
+        UCHAR* tail = (UCHAR*) ws;
+        UINT next = 0;
+        UINT i;
+
+        for(i = 0; i < offset; i++)
+        {
+            next |= ((UINT) tail[i]) << (i * 8);
+        }
 
-    RtMemcpypUnaligned(d, s, bytes % sizeof(INT));
+        *d = (current >> shift) | (next << (32 - shift));
+    }
 }
 
 VOID
@@ -401,15 +480,39 @@ RtMemcpy
         UINT bytes
     )
 {
-    if(0 == ((UINT) dest) % sizeof(UINT) &&
-       0 == ((UINT) src) % sizeof(UINT))
+    CHAR* d = dest;
+    CHAR* s = src;
+    UINT head;
+    UINT words;
+
+    if(bytes < RT_MEM_MIN_BLOCK_BYTES)
+    {
+        RtMemcpypBytes(d, s, bytes);
+        return;
+    }
+
+    // Byte copy until the destination is aligned
+    head = (sizeof(UINT) - ((UINTPTR) d) % sizeof(UINT)) % sizeof(UINT);
+    RtMemcpypBytes(d, s, head);
+    d += head;
+    s += head;
+    bytes -= head;
+
+    words = bytes / sizeof(UINT);
+
+    if(0 == ((UINTPTR) s) % sizeof(UINT))
     {
-        RtMemcpypAligned(dest, src, bytes);
+        RtMemcpypWords((UINT*) d, (UINT*) s, words);
     }
     else
     {
-        RtMemcpypUnaligned(dest, src, bytes);
+        RtMemcpypShiftedWords((UINT*) d, s, words);
     }
+
+    d += words * sizeof(UINT);
+    s += words * sizeof(UINT);
+
+    RtMemcpypBytes(d, s, bytes % sizeof(UINT));
 }
 
 VOID
@@ -421,9 +524,69 @@ RtMemset
     )
 {
     CHAR* p = dest;
+    UINT pattern = ((UCHAR) value) * 0x01010101;
+    UINT* w;
+    UINT blocks;
+    UINT words;
+
+    // Byte fill until aligned
+    while(size > 0 && 0 != ((UINTPTR) p) % sizeof(UINT))
+    {
+        *(p++) = value;
+        size--;
+    }
+
+    w = (UINT*) p;
+    words = size / sizeof(UINT);
+    blocks = words / RT_MEM_BLOCK_WORDS;
+
+    if(blocks > 0)
+    {
+#if NLOCAL
+        asm volatile("mov r3, %2\n\t"
+                     "mov r4, %2\n\t"
+                     "mov r5, %2\n\t"
+                     "mov r6, %2\n\t"
+                     "1:\n\t"
+                     "stmia %0!, {r3-r6}\n\t"
+                     "stmia %0!, {r3-r6}\n\t"
+                     "subs %1, %1, #1\n\t"
+                     "bne 1b"
+                     : "+r" (w), "+r" (blocks)
+                     : "r" (pattern)
+                     : "r3", "r4", "r5", "r6", "cc", "memory");
+#else
+        while(blocks > 0)
+        {
+            w[0] = pattern;
+            w[1] = pattern;
+            w[2] = pattern;
+            w[3] = pattern;
+            w[4] = pattern;
+            w[5] = pattern;
+            w[6] = pattern;
+            w[7] = pattern;
+
+            w += RT_MEM_BLOCK_WORDS;
+            blocks--;
+        }
+#endif
+    }
+
+    words = words % RT_MEM_BLOCK_WORDS;
+
+    while(words > 0)
+    {
+        *(w++) = pattern;
+        words--;
+    }
+
+    p = (CHAR*) w;
+    size = size % sizeof(UINT);
 
-    for (UINT i = 0; i < size; i++)
+    while(size > 0)
     {
-        p[i] = value;
+        *(p++) = value;
+        size--;
     }
 }
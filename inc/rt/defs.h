@@ -12,3 +12,6 @@
 #define abs(x) ((x) >= 0 ? (x) : -(x))
 
 #define SUCCESSFUL(x) ((x) >= 0)
+
+// Fails to compile unless expr is true.  name has to be unique in the file.
+#define compile_assert(name, expr) typedef CHAR name[(expr) ? 1 : -1]
@@ -2,6 +2,7 @@
 
 typedef int INT;
 typedef unsigned int UINT;
+typedef unsigned long UINTPTR;
 typedef short SHORT;
 typedef unsigned short USHORT;
 typedef char CHAR;
@@ -2,6 +2,8 @@
 
 #include "types.h"
 
+#if NLOCAL
+
 typedef CHAR* VA_LIST;
 
 #define __VA_ARGSIZ(t)  \
@@ -13,3 +15,17 @@ typedef CHAR* VA_LIST;
 
 #define VA_ARG(ap, t)   \
          (((ap) = (ap) + __VA_ARGSIZ(t)), *((t*) (PVOID) ((ap) - __VA_ARGSIZ(t))))
+
+#else
+
+// Host ABIs pass variable arguments in registers, so defer to the compiler.
+// Arguments smaller than an INT arrive promoted.
+typedef __builtin_va_list VA_LIST;
+
+#define VA_START(ap, pN) __builtin_va_start(ap, pN)
+
+#define VA_END(ap) __builtin_va_end(ap)
+
+#define VA_ARG(ap, t) ((t) __builtin_va_arg(ap, __typeof__(((t) 0) + 0)))
+
+#endif
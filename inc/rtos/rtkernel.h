@@ -53,6 +53,14 @@ VOID
         VOID
     );
 
+// Stack sizes a task can be created with
+typedef enum _STACK_CLASS {
+    SmallStack = 0,     // 4 KB, enough for notifiers
+    MediumStack,        // 16 KB
+    LargeStack,         // 64 KB, what Create() hands out
+    NumStackClass
+} STACK_CLASS;
+
 extern
 INT
 Create
@@ -61,6 +69,49 @@ Create
         IN TASK_START_FUNC code
     );
 
+extern
+INT
+CreateEx
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_FUNC code
+    );
+
+typedef
+VOID
+(*TASK_START_ARG_FUNC)
+    (
+        IN PVOID argument
+    );
+
+// Longest argument CreateWithArg() and CreateExWithArg() will copy
+#define MAX_TASK_ARGUMENT_LENGTH 64
+
+// Like Create(), but the kernel copies argumentLength bytes of argument on
+// to the new task's stack.  code gets a pointer to the copy, which lasts
+// as long as the task.
+extern
+INT
+CreateWithArg
+    (
+        IN TASK_PRIORITY priority,
+        IN TASK_START_ARG_FUNC code,
+        IN PVOID argument,
+        IN INT argumentLength
+    );
+
+extern
+INT
+CreateExWithArg
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_ARG_FUNC code,
+        IN PVOID argument,
+        IN INT argumentLength
+    );
+
 extern
 INT
 MyTid
@@ -113,6 +164,34 @@ Receive
         IN INT messageLength
     );
 
+// What ReceiveTimeout() and ReceiveUntil() return if nothing arrived in time
+#define RECEIVE_TIMED_OUT -1
+
+// Like Receive(), but gives up after the given number of clock ticks.
+// Zero or fewer ticks only takes a message that is already waiting.
+extern
+INT
+ReceiveTimeout
+    (
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    );
+
+// Like ReceiveTimeout(), but gives up on an absolute tick as seen by Time().
+// Once that tick has come it times out even if messages are waiting.
+extern
+INT
+ReceiveUntil
+    (
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength,
+        IN INT tick
+    );
+
+// Fails with -3 unless the task is blocked in a Send() to the caller
 extern
 INT
 Reply
@@ -122,6 +201,108 @@ Reply
         IN INT replyLength
     );
 
+// Opts the caller in to priority inheritance.  From then on, while a task
+// that outranks the caller is blocked in Send() to it, the caller runs at
+// that task's priority until it replies.
+extern
+VOID
+EnablePriorityInheritance
+    (
+        VOID
+    );
+
+// Longest message Post(), DelayedSend() and SendAt() will take
+#define MAX_POSTED_MESSAGE_LENGTH 64
+
+// Most posted messages a task can have waiting to be received
+#define MAX_POSTED_MESSAGES 16
+
+// What Post() returns if the receiver already has MAX_POSTED_MESSAGES waiting
+#define POST_QUEUE_FULL -5
+
+// What Post(), DelayedSend() and SendAt() return when every kernel message
+// buffer is in use.  Buffers free up as receivers drain their queues.
+#define POST_OUT_OF_MESSAGES -6
+
+// The kernel copies the message in to the receiver's queue and the caller
+// carries on.  The receiver gets it from Receive() as if the caller had
+// sent it, but must not Reply() to it.
+extern
+INT
+Post
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength
+    );
+
+// Post() the message once the given number of clock ticks has passed.
+// These are not held to MAX_POSTED_MESSAGES.
+extern
+INT
+DelayedSend
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    );
+
+// Like DelayedSend(), but delivers on an absolute tick as seen by Time()
+extern
+INT
+SendAt
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT tick
+    );
+
+/************************************
+ *          TOPIC API               *
+ ************************************/
+
+// Returns a new topic, or -1 once the kernel is out of them
+extern
+INT
+CreateTopic
+    (
+        VOID
+    );
+
+// How many of its last messages a topic holds on to.  Must be a power of 2.
+#define TOPIC_BACKLOG_LENGTH 16
+
+// Topics hold on to their last TOPIC_BACKLOG_LENGTH messages up to this long
+#define MAX_BUFFERED_TOPIC_MESSAGE_LENGTH 64
+
+// Returns the next message published to the topic since this task last
+// subscribed, blocking until there is one, and how many bytes of it were
+// copied in to the buffer.  A task's first Subscribe() waits for the next
+// Publish().  A task that falls more than TOPIC_BACKLOG_LENGTH messages
+// behind skips ahead to the oldest one still held.
+extern
+INT
+Subscribe
+    (
+        IN INT topic,
+        OUT PVOID buffer,
+        IN INT bufferLength
+    );
+
+// Copies the message to every task blocked in Subscribe() on the topic
+// and returns how many there were.  Never blocks.  Messages longer than
+// MAX_BUFFERED_TOPIC_MESSAGE_LENGTH are not held for later subscribers.
+extern
+INT
+Publish
+    (
+        IN INT topic,
+        IN PVOID message,
+        IN INT messageLength
+    );
+
 /************************************
  *          EVENT API               *
  ************************************/
@@ -136,6 +317,10 @@ typedef enum _EVENT
     NumEvent
 } EVENT;
 
+// Any number of tasks can wait on an event, and all of them wake when
+// it fires.  Returns how many times the event fired since the last
+// AwaitEvent() returned, which is more than 1 if the caller fell behind.
+// Returns -1 for the receive events, which carry data.
 extern
 INT
 AwaitEvent
@@ -143,12 +328,80 @@ AwaitEvent
         EVENT event
     );
 
+// The kernel drains the uart receivers itself.  Copies up to
+// bufferLength of the characters received since the last call in to
+// buffer, and blocks if there are none.  Returns the number copied.
+// Waiters are served in order, so each character goes to one task.
+// Returns -1 for events that carry no data.
+extern
+INT
+AwaitEventData
+    (
+        IN EVENT event,
+        OUT PVOID buffer,
+        IN INT bufferLength
+    );
+
 /************************************
  *       PERFORMANCE API            *
  ************************************/
 
+// Must match the swi numbers in rtos.asm
+typedef enum _SYSTEM_CALL_NUMBER {
+    CreateSystemCall = 0,
+    MyTidSystemCall,
+    MyParentTidSystemCall,
+    PassSystemCall,
+    ExitSystemCall,
+    SendSystemCall,
+    ReceiveSystemCall,
+    ReplySystemCall,
+    AwaitEventSystemCall,
+    QueryPerformanceSystemCall,
+    CreateExSystemCall,
+    DumpKernelTraceSystemCall,
+    QueryEventLatencySystemCall,
+    DelayedSendSystemCall,
+    SendAtSystemCall,
+    ReceiveTimeoutSystemCall,
+    PostSystemCall,
+    CreateTopicSystemCall,
+    SubscribeSystemCall,
+    PublishSystemCall,
+    AwaitEventDataSystemCall,
+    QueryPerformanceAllSystemCall,
+    EnablePriorityInheritanceSystemCall,
+    CreateWithArgSystemCall,
+    CreateExWithArgSystemCall,
+    ReadKernelTraceSystemCall,
+    ReceiveUntilSystemCall,
+    NumSystemCall
+} SYSTEM_CALL_NUMBER;
+
+// Utilization is in hundredths of a percent of the CPU
+#define FULL_UTILIZATION 10000
+
+// All times are in Timer3 ticks (508 khz)
 typedef struct _TASK_PERFORMANCE {
+    INT taskId;
     UINT activeTicks;
+    UINT utilization;       // Sampled every 100 ms, weighted toward the last second
+    UINT utilization1s;     // Over the last full 1 s window
+    UINT utilization10s;    // Over the last full 10 s window
+    UINT stackSize;         // 0 once the task has exited
+    UINT stackHighWater;    // Most bytes of stack the task has ever used
+    UINT systemCalls[NumSystemCall];
+    UINT contextSwitches;   // Times the task was switched in
+    UINT preemptions;       // Times an interrupt took the task off the CPU
+    UINT bytesSent;
+    UINT bytesReceived;
+    UINT bytesReplied;
+    UINT sendBlockedTicks;      // In Receive(), waiting for a sender
+    UINT receiveBlockedTicks;   // In Send(), waiting for the receiver
+    UINT replyBlockedTicks;     // In Send(), waiting for the reply
+    UINT eventBlockedTicks;     // In AwaitEvent() or AwaitEventData()
+    UINT subscribeBlockedTicks; // In Subscribe()
+    UINT inversionTicks;        // Ready but not running while a task that outranks it waits on it
 } TASK_PERFORMANCE;
 
 extern
@@ -158,3 +411,66 @@ QueryPerformance
         IN INT taskId,
         OUT TASK_PERFORMANCE* performance
     );
+
+// Fills in performance for up to numTasks live tasks.
+// Returns the number filled in.
+extern
+INT
+QueryPerformanceAll
+    (
+        OUT TASK_PERFORMANCE* performance,
+        IN INT numTasks
+    );
+
+#define NUM_LATENCY_BUCKETS 16
+
+// Time from an interrupt being taken to the task waiting on its event
+// running again.  buckets[i] counts latencies of 2^i up to 2^(i+1) Timer3
+// ticks (buckets[0] also counts 0), and the last bucket counts the rest.
+typedef struct _EVENT_LATENCY {
+    UINT count;
+    UINT totalTicks;
+    UINT maxTicks;
+    UINT buckets[NUM_LATENCY_BUCKETS];
+} EVENT_LATENCY;
+
+extern
+INT
+QueryEventLatency
+    (
+        IN EVENT event,
+        OUT EVENT_LATENCY* latency
+    );
+
+/************************************
+ *           TRACE API              *
+ ************************************/
+
+// Longest line ReadKernelTrace() hands out
+#define MAX_TRACE_LINE_LENGTH 32
+
+typedef enum _TRACE_DUMP {
+    TraceDumpNow = 0,
+    TraceDumpAtShutdown
+} TRACE_DUMP;
+
+// TraceDumpNow copies the kernel's event trace aside for ReadKernelTrace().
+// TraceDumpAtShutdown writes it straight to COM2 once every task has exited.
+// Writing 4096 records takes seconds, which is too long to stop the world.
+extern
+INT
+DumpKernelTrace
+    (
+        IN TRACE_DUMP when
+    );
+
+// Hands out the copy taken by DumpKernelTrace(TraceDumpNow) a few whole
+// lines at a time, in the format tools/trace_decode.py reads.  Returns the
+// number of characters copied, and 0 once the whole copy has been read.
+extern
+INT
+ReadKernelTrace
+    (
+        OUT STRING buffer,
+        IN INT bufferLength
+    );
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <rt.h>
+#include <rtkernel.h>
 
 /************************************
  *          NAME API                *
@@ -40,6 +41,66 @@ DelayUntil
         IN INT ticks
     );
 
+// Post() that waits a tick and tries again while the kernel is out of
+// message buffers or the receiver's queue is full
+INT
+PostRetry
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength
+    );
+
+#define MAX_DEFERRED_SENDS 8
+
+// A DelayedSend() to ourselves that is still waiting for a kernel message buffer
+typedef struct _DEFERRED_SEND
+{
+    INT tick;
+    INT messageLength;
+    UINT message[MAX_POSTED_MESSAGE_LENGTH / sizeof(UINT)];
+} DEFERRED_SEND;
+
+// Kept by a server that sends itself messages for later.  The server
+// must not wait for buffers in Delay(), since its own queued messages
+// only free theirs once it gets back to Receive().
+typedef struct _DEFERRED_SENDS
+{
+    INT taskId;
+    UINT count;
+    DEFERRED_SEND sends[MAX_DEFERRED_SENDS];
+} DEFERRED_SENDS;
+
+VOID
+DeferredSendsInit
+    (
+        OUT DEFERRED_SENDS* deferred
+    );
+
+// DelayedSend() to the calling task.  If the kernel is out of message
+// buffers the message is kept and sent by ReceiveDeferred(), still due
+// at the original tick.  Only returns POST_OUT_OF_MESSAGES once
+// MAX_DEFERRED_SENDS are already waiting.
+INT
+DelayedSendSelf
+    (
+        IN DEFERRED_SENDS* deferred,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    );
+
+// Receive() that first retries any deferred sends.  While some are still
+// waiting it wakes every tick to try again.
+INT
+ReceiveDeferred
+    (
+        IN DEFERRED_SENDS* deferred,
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength
+    );
+
 /************************************
  *       I/O SERVER API             *
  ************************************/
@@ -157,6 +218,50 @@ Shutdown
         VOID
     );
 
+/************************************
+ *          SERVICE API             *
+ ************************************/
+
+typedef
+VOID
+(*SERVICE_INIT_FUNC)
+    (
+        VOID
+    );
+
+// One entry in a boot manifest.  init is optional and
+// runs in the boot task right before the service is created.
+typedef struct _SERVICE
+{
+    TASK_START_FUNC startFunc;
+    TASK_PRIORITY priority;
+    STACK_CLASS stackClass;
+    SERVICE_INIT_FUNC init;
+} SERVICE;
+
+VOID
+ServiceDeclare
+    (
+        OUT SERVICE* service,
+        IN TASK_START_FUNC startFunc,
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN SERVICE_INIT_FUNC init
+    );
+
+// Creates every service in the manifest and stores its task id at the
+// same index of taskIds.  The caller must outrank all of the services,
+// so that none of them run before every task id is known.  The boot
+// tasks are never lowered afterward.  Instead they only create tasks
+// from here on and then exit, so the raised priority only lasts for boot.
+VOID
+ServiceCreateAll
+    (
+        IN SERVICE* manifest,
+        IN UINT numServices,
+        OUT INT* taskIds
+    );
+
 /************************************
  *            INIT TASK             *
  ************************************/
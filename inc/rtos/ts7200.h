@@ -7,9 +7,42 @@
  *
  */
 
-#define	TIMER1_BASE	0x80810000
-#define	TIMER2_BASE	0x80810020
-#define	TIMER3_BASE	0x80810080
+#if NLOCAL
+
+#define	HARDWARE_BASE(address, offset)	(address)
+
+#define	UART_READ_DATA(base)	(*(volatile unsigned int *)((base) + UART_DATA_OFFSET))
+#define	UART_WRITE_DATA(base, data)	(*(volatile unsigned int *)((base) + UART_DATA_OFFSET) = (data))
+
+#else
+
+/*
+ * Local builds have no memory mapped peripherals.  The registers live in
+ * a block of host memory instead, which the host kernel keeps in sync with
+ * its models of the timers, uarts and interrupt controllers.
+ */
+#define	HARDWARE_REGISTERS_SIZE	0x7000
+
+extern unsigned int g_hardwareRegisters[];
+
+#define	HARDWARE_BASE(address, offset)	((unsigned long) g_hardwareRegisters + (offset))
+
+/*
+ * Reading or writing a uart's data register moves characters through its
+ * fifos, which a plain block of memory cannot do.  Those accesses go
+ * through the host kernel's uart models instead.
+ */
+unsigned int HardwareUartReadData(unsigned long base);
+void HardwareUartWriteData(unsigned long base, unsigned int data);
+
+#define	UART_READ_DATA(base)	HardwareUartReadData(base)
+#define	UART_WRITE_DATA(base, data)	HardwareUartWriteData((base), (data))
+
+#endif
+
+#define	TIMER1_BASE	HARDWARE_BASE(0x80810000, 0x0000)
+#define	TIMER2_BASE	HARDWARE_BASE(0x80810020, 0x0020)
+#define	TIMER3_BASE	HARDWARE_BASE(0x80810080, 0x0080)
 
 #define	LDR_OFFSET	0x00000000	// 16/32 bits, RW
 #define	VAL_OFFSET	0x00000004	// 16/32 bits, RO
@@ -20,7 +53,7 @@
 #define CLR_OFFSET	0x0000000c	// no data, WO
 
 
-#define LED_ADDRESS	0x80840020
+#define LED_ADDRESS	HARDWARE_BASE(0x80840020, 0x6020)
 	#define LED_NONE	0x0
 	#define LED_GREEN	0x1
 	#define LED_RED		0x2
@@ -29,9 +62,9 @@
 #define COM1	0
 #define COM2	1
 
-#define IRDA_BASE	0x808b0000
-#define UART1_BASE	0x808c0000
-#define UART2_BASE	0x808d0000
+#define IRDA_BASE	HARDWARE_BASE(0x808b0000, 0x1000)
+#define UART1_BASE	HARDWARE_BASE(0x808c0000, 0x2000)
+#define UART2_BASE	HARDWARE_BASE(0x808d0000, 0x3000)
 
 // All the below registers for UART1
 // First nine registers (up to Ox28) for UART 2
@@ -87,4 +120,5 @@
 #define UART_HDLCRIB_OFFSET	0x218
 #define UART_HDLCSTS_OFFSET	0x21c
 
-
+#define VIC1_BASE	HARDWARE_BASE(0x800b0000, 0x4000)
+#define VIC2_BASE	HARDWARE_BASE(0x800c0000, 0x5000)
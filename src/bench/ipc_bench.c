@@ -0,0 +1,298 @@
+#include <rtosc/assert.h>
+#include <rtosc/string.h>
+#include <rtkernel.h>
+#include <rtos.h>
+#include <ts7200.h>
+#include <user/users.h>
+
+#define IPC_BENCH_ITERATIONS 1000
+
+// MyTid() and friends take well under a microsecond, and the host only
+// moves Timer3 when it polls its hardware models every 100 us.  Run them
+// long enough to span many polls.  Must be a multiple of 1000.
+#define IPC_BENCH_SYSTEM_CALL_ITERATIONS 1000000
+
+#define IPC_BENCH_MAX_MESSAGE_SIZE 256
+#define IPC_BENCH_NUM_SIZES 3
+#define IPC_BENCH_NUM_CASES (IPC_BENCH_NUM_SIZES * 4)
+
+// Timer3 runs at 508 khz
+#define IPC_BENCH_NS_PER_TICK 1967
+
+// The EP9302's ARM920T runs at 200 mhz.  Cycles mean nothing on the host.
+#if NLOCAL
+#define IPC_BENCH_CYCLES_PER_US 200
+#endif
+
+#define IPC_BENCH_PRIORITY Priority10
+#define IPC_BENCH_HIGH_PRIORITY Priority11
+
+#define TIMER3_VALUE ((volatile UINT*) (TIMER3_BASE + VAL_OFFSET))
+
+typedef enum _IPC_BENCH_ORDER
+{
+    ReceiverFirstOrder = 0,
+    SenderFirstOrder
+} IPC_BENCH_ORDER;
+
+typedef struct _IPC_BENCH_CASE
+{
+    INT messageSize;
+    IPC_BENCH_ORDER order;
+    BOOLEAN samePriority;
+    UINT ticks;
+} IPC_BENCH_CASE;
+
+typedef enum _IPC_BENCH_SYSTEM_CALL
+{
+    MyTidBenchCall = 0,
+    MyParentTidBenchCall,
+    PassBenchCall,
+    NumBenchCall
+} IPC_BENCH_SYSTEM_CALL;
+
+static const INT g_messageSizes[IPC_BENCH_NUM_SIZES] = { 4, 64, 256 };
+static const STRING g_systemCallNames[NumBenchCall] = { "MyTid()      ", "MyParentTid()", "Pass()       " };
+static IPC_BENCH_CASE g_cases[IPC_BENCH_NUM_CASES];
+static UINT g_systemCallTicks[NumBenchCall];
+static IPC_BENCH_CASE* g_currentCase;
+static INT g_receiverId;
+
+static
+VOID
+IpcBenchpReceiverTask
+    (
+        VOID
+    )
+{
+    CHAR buffer[IPC_BENCH_MAX_MESSAGE_SIZE];
+    IPC_BENCH_CASE* benchCase = g_currentCase;
+    BOOLEAN yield = SenderFirstOrder == benchCase->order && benchCase->samePriority;
+    UINT i;
+
+    // One extra round trip for the sender's warm up
+    for(i = 0; i < IPC_BENCH_ITERATIONS + 1; i++)
+    {
+        INT senderId;
+
+        VERIFY(benchCase->messageSize == Receive(&senderId, buffer, benchCase->messageSize));
+        VERIFY(SUCCESSFUL(Reply(senderId, buffer, benchCase->messageSize)));
+
+        // Let the sender run before we get back to Receive()
+        if(yield)
+        {
+            Pass();
+        }
+    }
+}
+
+static
+VOID
+IpcBenchpSenderTask
+    (
+        VOID
+    )
+{
+    CHAR message[IPC_BENCH_MAX_MESSAGE_SIZE];
+    CHAR reply[IPC_BENCH_MAX_MESSAGE_SIZE];
+    IPC_BENCH_CASE* benchCase = g_currentCase;
+    BOOLEAN yield = ReceiverFirstOrder == benchCase->order && benchCase->samePriority;
+    UINT start;
+    UINT i;
+
+    RtMemset(message, sizeof(message), 0xA5);
+
+    // The first round trip always finds the receiver blocked.
+    // Get it out of the way so every timed round trip takes the same path.
+    VERIFY(benchCase->messageSize == Send(g_receiverId, message, benchCase->messageSize, reply, benchCase->messageSize));
+
+    if(yield)
+    {
+        Pass();
+    }
+
+    start = *TIMER3_VALUE;
+
+    for(i = 0; i < IPC_BENCH_ITERATIONS; i++)
+    {
+        Send(g_receiverId, message, benchCase->messageSize, reply, benchCase->messageSize);
+
+        // Let the receiver get back to Receive() before we send again
+        if(yield)
+        {
+            Pass();
+        }
+    }
+
+    // Timer3 counts down
+    benchCase->ticks = start - *TIMER3_VALUE;
+}
+
+static
+VOID
+IpcBenchpRun
+    (
+        IN IPC_BENCH_CASE* benchCase
+    )
+{
+    TASK_PRIORITY receiverPriority = IPC_BENCH_PRIORITY;
+
+    // A higher priority receiver is always waiting in Receive() by the time
+    // the sender runs again.  A lower priority one has not got there yet.
+    // Tasks at the same priority Pass() to get the order they want.
+    if(!benchCase->samePriority)
+    {
+        receiverPriority = ReceiverFirstOrder == benchCase->order
+                           ? IPC_BENCH_HIGH_PRIORITY
+                           : IPC_BENCH_PRIORITY;
+    }
+
+    g_currentCase = benchCase;
+
+    // Both tasks outrank us, so they run to completion before Create() returns
+    g_receiverId = Create(receiverPriority, IpcBenchpReceiverTask);
+    VERIFY(SUCCESSFUL(g_receiverId));
+
+    VERIFY(SUCCESSFUL(Create(benchCase->samePriority || ReceiverFirstOrder == benchCase->order
+                             ? IPC_BENCH_PRIORITY
+                             : IPC_BENCH_HIGH_PRIORITY,
+                             IpcBenchpSenderTask)));
+}
+
+static
+VOID
+IpcBenchpRunSystemCalls
+    (
+        VOID
+    )
+{
+    UINT start;
+    UINT i;
+
+    // Nothing else is ready at our priority, so Pass() returns straight away
+    start = *TIMER3_VALUE;
+
+    for(i = 0; i < IPC_BENCH_SYSTEM_CALL_ITERATIONS; i++)
+    {
+        MyTid();
+    }
+
+    g_systemCallTicks[MyTidBenchCall] = start - *TIMER3_VALUE;
+    start = *TIMER3_VALUE;
+
+    for(i = 0; i < IPC_BENCH_SYSTEM_CALL_ITERATIONS; i++)
+    {
+        MyParentTid();
+    }
+
+    g_systemCallTicks[MyParentTidBenchCall] = start - *TIMER3_VALUE;
+    start = *TIMER3_VALUE;
+
+    for(i = 0; i < IPC_BENCH_SYSTEM_CALL_ITERATIONS; i++)
+    {
+        Pass();
+    }
+
+    g_systemCallTicks[PassBenchCall] = start - *TIMER3_VALUE;
+}
+
+static
+VOID
+IpcBenchpPrintResults
+    (
+        VOID
+    )
+{
+    IO_DEVICE com2;
+    UINT i;
+
+    VERIFY(SUCCESSFUL(Open(UartDevice, ChannelCom2, &com2)));
+
+    WriteFormattedString(&com2, "\r\nSend-Receive-Reply round trip, %d iterations per case\r\n", IPC_BENCH_ITERATIONS);
+    WriteString(&com2, " bytes  first     priority      ticks    ns/rt\r\n");
+
+    for(i = 0; i < IPC_BENCH_NUM_CASES; i++)
+    {
+        IPC_BENCH_CASE* benchCase = &g_cases[i];
+
+        WriteFormattedString(&com2,
+                             "%6d  %s  %s  %8u %8u\r\n",
+                             benchCase->messageSize,
+                             ReceiverFirstOrder == benchCase->order ? "receiver" : "sender  ",
+                             benchCase->samePriority ? "same     " : "different",
+                             benchCase->ticks,
+                             (benchCase->ticks * IPC_BENCH_NS_PER_TICK) / IPC_BENCH_ITERATIONS);
+    }
+
+    WriteString(&com2, "Cases at the same priority include a Pass() per round trip\r\n");
+
+    WriteFormattedString(&com2, "\r\nSystem calls, %d iterations each\r\n", IPC_BENCH_SYSTEM_CALL_ITERATIONS);
+#if NLOCAL
+    WriteString(&com2, " call              ticks  ns/call cycles/call\r\n");
+#else
+    WriteString(&com2, " call              ticks  ns/call\r\n");
+#endif
+
+    for(i = 0; i < NumBenchCall; i++)
+    {
+        // Split the ticks so that multiplying by the tick length can't overflow
+        UINT ticks = g_systemCallTicks[i];
+        UINT ns = ((ticks / 1000) * IPC_BENCH_NS_PER_TICK +
+                   ((ticks % 1000) * IPC_BENCH_NS_PER_TICK) / 1000) / (IPC_BENCH_SYSTEM_CALL_ITERATIONS / 1000);
+
+#if NLOCAL
+        WriteFormattedString(&com2,
+                             " %s  %8u %8u %11u\r\n",
+                             g_systemCallNames[i],
+                             g_systemCallTicks[i],
+                             ns,
+                             (ns * IPC_BENCH_CYCLES_PER_US) / 1000);
+#else
+        WriteFormattedString(&com2,
+                             " %s  %8u %8u\r\n",
+                             g_systemCallNames[i],
+                             g_systemCallTicks[i],
+                             ns);
+#endif
+    }
+
+#ifdef NTRAP_FAST_PATH
+    WriteString(&com2, "Built with the system call fast path turned off\r\n");
+#endif
+}
+
+static
+VOID
+IpcBenchpTask
+    (
+        VOID
+    )
+{
+    UINT i;
+
+    for(i = 0; i < IPC_BENCH_NUM_CASES; i++)
+    {
+        IPC_BENCH_CASE* benchCase = &g_cases[i];
+
+        benchCase->messageSize = g_messageSizes[i / 4];
+        benchCase->order = (i / 2) % 2 ? SenderFirstOrder : ReceiverFirstOrder;
+        benchCase->samePriority = 0 == i % 2;
+        benchCase->ticks = 0;
+
+        IpcBenchpRun(benchCase);
+    }
+
+    IpcBenchpRunSystemCalls();
+    IpcBenchpPrintResults();
+
+    Shutdown();
+}
+
+VOID
+InitUserTasks
+    (
+        VOID
+    )
+{
+    VERIFY(SUCCESSFUL(Create(LowestUserPriority, IpcBenchpTask)));
+}
@@ -0,0 +1,207 @@
+#include <rtosc/assert.h>
+#include <rtosc/string.h>
+#include <rtkernel.h>
+#include <rtos.h>
+#include <ts7200.h>
+#include <user/users.h>
+
+#define MEMCPY_BENCH_BYTES (1024 * 1024)
+#define MEMCPY_BENCH_MAX_SIZE 4096
+#define MEMCPY_BENCH_NUM_SIZES 5
+
+// Timer3 runs at 508 khz
+#define MEMCPY_BENCH_NS_PER_TICK 1967
+
+#define TIMER3_VALUE ((volatile UINT*) (TIMER3_BASE + VAL_OFFSET))
+
+typedef VOID (*MEMCPY_BENCH_COPY_FUNC)(PVOID dest, PVOID src, UINT bytes);
+
+static const UINT g_sizes[MEMCPY_BENCH_NUM_SIZES] = { 16, 64, 256, 1024, 4096 };
+
+// One spare word so the misaligned cases stay in bounds
+static UINT g_source[(MEMCPY_BENCH_MAX_SIZE / sizeof(UINT)) + 1];
+static UINT g_destination[(MEMCPY_BENCH_MAX_SIZE / sizeof(UINT)) + 1];
+
+// RtMemcpy and RtMemset from before they moved whole blocks, for comparison
+static
+VOID
+MemcpyBenchpReferenceCopyUnaligned
+    (
+        PVOID dest,
+        PVOID src,
+        UINT bytes
+    )
+{
+    CHAR* d = dest;
+    CHAR* s = src;
+
+    while(bytes > 0)
+    {
+        *(d++) = *(s++);
+        bytes--;
+    }
+}
+
+static
+VOID
+MemcpyBenchpReferenceCopy
+    (
+        PVOID dest,
+        PVOID src,
+        UINT bytes
+    )
+{
+    if(0 == ((UINTPTR) dest) % sizeof(UINT) &&
+       0 == ((UINTPTR) src) % sizeof(UINT))
+    {
+        INT* d = dest;
+        INT* s = src;
+        UINT words = bytes / sizeof(INT);
+
+        while(words > 0)
+        {
+            *(d++) = *(s++);
+            words--;
+        }
+
+        MemcpyBenchpReferenceCopyUnaligned(d, s, bytes % sizeof(INT));
+    }
+    else
+    {
+        MemcpyBenchpReferenceCopyUnaligned(dest, src, bytes);
+    }
+}
+
+static
+VOID
+MemcpyBenchpReferenceSet
+    (
+        PVOID dest,
+        UINT size,
+        CHAR value
+    )
+{
+    CHAR* p = dest;
+
+    for (UINT i = 0; i < size; i++)
+    {
+        p[i] = value;
+    }
+}
+
+static
+UINT
+MemcpyBenchpTimeCopy
+    (
+        IN MEMCPY_BENCH_COPY_FUNC copy,
+        IN UINT size,
+        IN BOOLEAN misaligned
+    )
+{
+    // Misaligned buffers are also one byte apart from each other
+    PVOID dest = ptr_add(g_destination, misaligned ? 2 : 0);
+    PVOID src = ptr_add(g_source, misaligned ? 1 : 0);
+    UINT iterations = MEMCPY_BENCH_BYTES / size;
+    UINT start = *TIMER3_VALUE;
+    UINT i;
+
+    for(i = 0; i < iterations; i++)
+    {
+        copy(dest, src, size);
+    }
+
+    // Timer3 counts down
+    return start - *TIMER3_VALUE;
+}
+
+static
+UINT
+MemcpyBenchpTimeSet
+    (
+        IN BOOLEAN reference,
+        IN UINT size
+    )
+{
+    UINT iterations = MEMCPY_BENCH_BYTES / size;
+    UINT start = *TIMER3_VALUE;
+    UINT i;
+
+    for(i = 0; i < iterations; i++)
+    {
+        if(reference)
+        {
+            MemcpyBenchpReferenceSet(g_destination, size, (CHAR) i);
+        }
+        else
+        {
+            RtMemset(g_destination, size, (CHAR) i);
+        }
+    }
+
+    return start - *TIMER3_VALUE;
+}
+
+static
+UINT
+MemcpyBenchpNsPerKb
+    (
+        IN UINT ticks
+    )
+{
+    return (ticks * MEMCPY_BENCH_NS_PER_TICK) / (MEMCPY_BENCH_BYTES / 1024);
+}
+
+static
+VOID
+MemcpyBenchpTask
+    (
+        VOID
+    )
+{
+    IO_DEVICE com2;
+    UINT i;
+
+    VERIFY(SUCCESSFUL(Open(UartDevice, ChannelCom2, &com2)));
+
+    RtMemset(g_source, sizeof(g_source), 0xA5);
+
+    WriteFormattedString(&com2, "\r\nRtMemcpy and RtMemset, %d bytes per case, ns/KB\r\n", MEMCPY_BENCH_BYTES);
+    WriteString(&com2, "  size  case        reference      rtosc\r\n");
+
+    for(i = 0; i < MEMCPY_BENCH_NUM_SIZES; i++)
+    {
+        UINT size = g_sizes[i];
+
+        WriteFormattedString(&com2,
+                             "%6u  %s  %9u  %9u\r\n",
+                             size,
+                             "aligned   ",
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeCopy(MemcpyBenchpReferenceCopy, size, FALSE)),
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeCopy(RtMemcpy, size, FALSE)));
+
+        WriteFormattedString(&com2,
+                             "%6u  %s  %9u  %9u\r\n",
+                             size,
+                             "misaligned",
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeCopy(MemcpyBenchpReferenceCopy, size, TRUE)),
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeCopy(RtMemcpy, size, TRUE)));
+
+        WriteFormattedString(&com2,
+                             "%6u  %s  %9u  %9u\r\n",
+                             size,
+                             "memset    ",
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeSet(TRUE, size)),
+                             MemcpyBenchpNsPerKb(MemcpyBenchpTimeSet(FALSE, size)));
+    }
+
+    Shutdown();
+}
+
+VOID
+InitUserTasks
+    (
+        VOID
+    )
+{
+    VERIFY(SUCCESSFUL(Create(LowestUserPriority, MemcpyBenchpTask)));
+}
@@ -0,0 +1,142 @@
+#include "clock.h"
+
+#include <rtosc/assert.h>
+#include "scheduler.h"
+#include "task.h"
+
+// Counts the same 10 ms timer interrupts as the clock server.  The
+// kernel sees each one before the clock notifier does, so this is
+// never behind Time().
+static UINT g_clockTicks;
+
+// Messages waiting on the clock, soonest first
+static IPC_MESSAGE* g_delayedMessages;
+
+// Tasks in ReceiveTimeout(), soonest first
+static TASK_DESCRIPTOR* g_timeouts;
+
+static
+inline
+BOOLEAN
+ClockpIsDue
+    (
+        IN UINT deliveryTick,
+        IN UINT currentTick
+    )
+{
+    return (INT) (deliveryTick - currentTick) <= 0;
+}
+
+VOID
+ClockInit
+    (
+        VOID
+    )
+{
+    g_clockTicks = 0;
+    g_delayedMessages = NULL;
+    g_timeouts = NULL;
+}
+
+VOID
+ClockTick
+    (
+        VOID
+    )
+{
+    g_clockTicks++;
+
+    while(NULL != g_delayedMessages &&
+          ClockpIsDue(g_delayedMessages->deliveryTick, g_clockTicks))
+    {
+        IPC_MESSAGE* ipcMessage = g_delayedMessages;
+
+        g_delayedMessages = ipcMessage->next;
+
+        // The receiver may have exited in the mean time.  That is fine.
+        (VOID) IpcPostMessage(ipcMessage);
+    }
+
+    while(NULL != g_timeouts &&
+          ClockpIsDue(g_timeouts->timeoutTick, g_clockTicks))
+    {
+        TASK_DESCRIPTOR* td = g_timeouts;
+
+        g_timeouts = td->nextTimeout;
+        td->timeoutPending = FALSE;
+
+        // Nobody sent anything, so give up on the Receive()
+        TaskSetReturnValue(td, RECEIVE_TIMED_OUT);
+        td->state = ReadyState;
+        VERIFY(RT_SUCCESS(SchedulerAddTask(td)));
+    }
+}
+
+UINT
+ClockGetTicks
+    (
+        VOID
+    )
+{
+    return g_clockTicks;
+}
+
+VOID
+ClockDelayMessage
+    (
+        IN IPC_MESSAGE* ipcMessage,
+        IN UINT deliveryTick
+    )
+{
+    IPC_MESSAGE** link = &g_delayedMessages;
+
+    ipcMessage->deliveryTick = deliveryTick;
+
+    // Messages due on the same tick are delivered in the order they were sent
+    while(NULL != *link && ClockpIsDue((*link)->deliveryTick, deliveryTick))
+    {
+        link = &(*link)->next;
+    }
+
+    ipcMessage->next = *link;
+    *link = ipcMessage;
+}
+
+VOID
+ClockTimeoutReceive
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN UINT timeoutTick
+    )
+{
+    TASK_DESCRIPTOR** link = &g_timeouts;
+
+    td->timeoutTick = timeoutTick;
+    td->timeoutPending = TRUE;
+
+    while(NULL != *link && ClockpIsDue((*link)->timeoutTick, timeoutTick))
+    {
+        link = &(*link)->nextTimeout;
+    }
+
+    td->nextTimeout = *link;
+    *link = td;
+}
+
+VOID
+ClockCancelTimeout
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    TASK_DESCRIPTOR** link = &g_timeouts;
+
+    // Only a handful of tasks ever wait with a timeout
+    while(td != *link)
+    {
+        link = &(*link)->nextTimeout;
+    }
+
+    *link = td->nextTimeout;
+    td->timeoutPending = FALSE;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <rt.h>
+#include "ipc.h"
+
+VOID
+ClockInit
+    (
+        VOID
+    );
+
+VOID
+ClockTick
+    (
+        VOID
+    );
+
+UINT
+ClockGetTicks
+    (
+        VOID
+    );
+
+VOID
+ClockDelayMessage
+    (
+        IN IPC_MESSAGE* ipcMessage,
+        IN UINT deliveryTick
+    );
+
+VOID
+ClockTimeoutReceive
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN UINT timeoutTick
+    );
+
+VOID
+ClockCancelTimeout
+    (
+        IN TASK_DESCRIPTOR* td
+    );
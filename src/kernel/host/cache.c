@@ -0,0 +1,10 @@
+#include "cache.h"
+
+VOID
+CacheInit
+    (
+        VOID
+    )
+{
+    // The host manages its own caches
+}
@@ -0,0 +1,648 @@
+#include "hardware.h"
+
+#include <poll.h>
+#include <rtosc/assert.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <ts7200.h>
+#include <unistd.h>
+
+#define HARDWARE_REGISTER(base, offset) ((volatile UINT*) ((base) + (offset)))
+#define HARDWARE_INDEX(offset) ((offset) / sizeof(UINT))
+
+// Offsets of the peripherals in g_hardwareRegisters, see ts7200.h
+#define HARDWARE_UART1 0x2000
+#define HARDWARE_UART2 0x3000
+
+#define VIC_STATUS_OFFSET 0x0
+#define VIC_ENABLE_OFFSET 0x10
+#define VIC_DISABLE_OFFSET 0x14
+
+#define TC2IO_MASK 0x20
+#define UART1_MASK 0x100000
+#define UART2_MASK 0x400000
+
+#define UART_CLK 7372800
+#define TIMER_CLK 508469
+#define NANOSECONDS_PER_SECOND 1000000000ULL
+
+// Values loaded by the hardware are tagged with this bit.  Software only
+// writes TRUE to the interrupt register, so a register that no longer
+// holds the loaded value has been written to.
+#define HARDWARE_LOADED 0x100
+
+#define HARDWARE_INPUT_POLL_INTERVAL 1000000
+#define HARDWARE_INPUT_BUFFER_SIZE 256
+
+// The EP9302 uarts buffer 16 characters each way with their fifos enabled,
+// and 1 without.  The receive timeout fires after 32 idle bit periods.
+#define HARDWARE_UART_FIFO_SIZE 16
+#define HARDWARE_UART_TIMEOUT_CHARACTERS 3
+
+// Marklin 6051 commands
+#define TRAIN_COMMAND_SWITCH_STRAIGHT 0x21
+#define TRAIN_COMMAND_SWITCH_CURVED 0x22
+#define TRAIN_COMMAND_SENSOR_DUMP 0x80
+#define TRAIN_COMMAND_SENSOR_POLL 0xC0
+#define TRAIN_NUM_SENSOR_MODULES 31
+#define TRAIN_SENSOR_MODULE_SIZE 2
+
+typedef unsigned long long HARDWARE_TIME;
+
+typedef struct _HARDWARE_TIMER
+{
+    UINTPTR base;
+    BOOLEAN enabled;
+    BOOLEAN pending;
+    HARDWARE_TIME start;
+    HARDWARE_TIME underflows;
+} HARDWARE_TIMER;
+
+typedef struct _HARDWARE_UART HARDWARE_UART;
+
+typedef VOID (*HARDWARE_UART_OUTPUT)(HARDWARE_UART* uart, UCHAR c);
+
+struct _HARDWARE_UART
+{
+    UINTPTR base;
+    BOOLEAN flowControl;
+    HARDWARE_UART_OUTPUT output;
+
+    // Characters on their way in from the other end of the line
+    UCHAR input[HARDWARE_INPUT_BUFFER_SIZE];
+    UINT inputStart;
+    UINT inputCount;
+    HARDWARE_TIME receiveDone;
+
+    // Received characters that software has not read yet
+    UCHAR receiveFifo[HARDWARE_UART_FIFO_SIZE];
+    UINT receiveStart;
+    UINT receiveCount;
+    HARDWARE_TIME lastReceived;
+
+    // Written characters.  The first one is on the line while transmitting.
+    UCHAR transmitFifo[HARDWARE_UART_FIFO_SIZE];
+    UINT transmitStart;
+    UINT transmitCount;
+    BOOLEAN transmitting;
+    HARDWARE_TIME transmitDone;
+
+    BOOLEAN clearToSend;
+    BOOLEAN modemStatusChanged;
+
+    UINT status;
+};
+
+// Power on state of the registers
+UINT g_hardwareRegisters[HARDWARE_REGISTERS_SIZE / sizeof(UINT)] =
+{
+    [HARDWARE_INDEX(HARDWARE_UART1 + UART_FLAG_OFFSET)] = CTS_MASK | RXFE_MASK | TXFE_MASK,
+    [HARDWARE_INDEX(HARDWARE_UART1 + UART_INTR_OFFSET)] = HARDWARE_LOADED,
+    [HARDWARE_INDEX(HARDWARE_UART2 + UART_FLAG_OFFSET)] = CTS_MASK | RXFE_MASK | TXFE_MASK,
+    [HARDWARE_INDEX(HARDWARE_UART2 + UART_INTR_OFFSET)] = HARDWARE_LOADED,
+};
+
+static
+VOID
+HardwarepTrainControllerOutput
+    (
+        IN HARDWARE_UART* uart,
+        IN UCHAR c
+    );
+
+static
+VOID
+HardwarepTerminalOutput
+    (
+        IN HARDWARE_UART* uart,
+        IN UCHAR c
+    );
+
+static HARDWARE_TIMER g_timer2 = { TIMER2_BASE };
+static HARDWARE_TIMER g_timer3 = { TIMER3_BASE };
+
+static HARDWARE_UART g_uart1 =
+{
+    .base = UART1_BASE,
+    .flowControl = TRUE,
+    .output = HardwarepTrainControllerOutput,
+    .clearToSend = TRUE,
+    .status = HARDWARE_LOADED
+};
+
+static HARDWARE_UART g_uart2 =
+{
+    .base = UART2_BASE,
+    .flowControl = FALSE,
+    .output = HardwarepTerminalOutput,
+    .clearToSend = TRUE,
+    .status = HARDWARE_LOADED
+};
+
+static UINT g_vic1Enabled;
+static UINT g_vic2Enabled;
+
+static BOOLEAN g_inputOpen;
+static HARDWARE_TIME g_nextInputPoll;
+static BOOLEAN g_terminalChanged;
+static struct termios g_terminalSettings;
+
+static
+inline
+HARDWARE_TIME
+HardwarepNow
+    (
+        VOID
+    )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec * NANOSECONDS_PER_SECOND) + now.tv_nsec;
+}
+
+// Runs when the process exits
+static
+VOID
+__attribute__((destructor))
+HardwarepRestoreTerminal
+    (
+        VOID
+    )
+{
+    if(g_terminalChanged)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &g_terminalSettings);
+    }
+}
+
+VOID
+HardwareInit
+    (
+        VOID
+    )
+{
+    g_inputOpen = TRUE;
+    g_nextInputPoll = 0;
+
+    // Deliver keystrokes as they are typed, and let the
+    // terminal server do the echoing
+    if(isatty(STDIN_FILENO) && 0 == tcgetattr(STDIN_FILENO, &g_terminalSettings))
+    {
+        struct termios settings = g_terminalSettings;
+
+        settings.c_lflag &= ~(ICANON | ECHO);
+        settings.c_cc[VMIN] = 1;
+        settings.c_cc[VTIME] = 0;
+
+        g_terminalChanged = (0 == tcsetattr(STDIN_FILENO, TCSANOW, &settings));
+    }
+
+    // Pick up anything the kernel wrote before the models were running
+    HardwareUpdate();
+}
+
+static
+VOID
+HardwarepUartInput
+    (
+        IN HARDWARE_UART* uart,
+        IN UCHAR c
+    )
+{
+    if(uart->inputCount < HARDWARE_INPUT_BUFFER_SIZE)
+    {
+        UINT index = (uart->inputStart + uart->inputCount) % HARDWARE_INPUT_BUFFER_SIZE;
+
+        uart->input[index] = c;
+        uart->inputCount++;
+    }
+}
+
+static
+VOID
+HardwarepTerminalOutput
+    (
+        IN HARDWARE_UART* uart,
+        IN UCHAR c
+    )
+{
+    if(write(STDOUT_FILENO, &c, sizeof(c)) < 0)
+    {
+        // Nowhere to report the error
+    }
+}
+
+static
+VOID
+HardwarepTrainControllerOutput
+    (
+        IN HARDWARE_UART* uart,
+        IN UCHAR c
+    )
+{
+    static BOOLEAN s_expectingAddress = FALSE;
+    UINT modules = 0;
+    UINT i;
+
+    // Speed and switch commands are followed by an address
+    if(s_expectingAddress)
+    {
+        s_expectingAddress = FALSE;
+    }
+    else if(c < 0x20 ||
+            TRAIN_COMMAND_SWITCH_STRAIGHT == c ||
+            TRAIN_COMMAND_SWITCH_CURVED == c)
+    {
+        s_expectingAddress = TRUE;
+    }
+    else if(TRAIN_COMMAND_SENSOR_DUMP < c && c <= TRAIN_COMMAND_SENSOR_DUMP + TRAIN_NUM_SENSOR_MODULES)
+    {
+        modules = c - TRAIN_COMMAND_SENSOR_DUMP;
+    }
+    else if(TRAIN_COMMAND_SENSOR_POLL < c && c <= TRAIN_COMMAND_SENSOR_POLL + TRAIN_NUM_SENSOR_MODULES)
+    {
+        modules = 1;
+    }
+
+    // No trains are moving, so none of the sensors are ever tripped
+    for(i = 0; i < modules * TRAIN_SENSOR_MODULE_SIZE; i++)
+    {
+        HardwarepUartInput(uart, 0);
+    }
+}
+
+static
+inline
+VOID
+HardwarepPollInput
+    (
+        IN HARDWARE_TIME now
+    )
+{
+    struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+
+    if(!g_inputOpen || now < g_nextInputPoll)
+    {
+        return;
+    }
+
+    g_nextInputPoll = now + HARDWARE_INPUT_POLL_INTERVAL;
+
+    while(g_uart2.inputCount < HARDWARE_INPUT_BUFFER_SIZE &&
+          poll(&input, 1, 0) > 0)
+    {
+        UCHAR c;
+
+        if(read(STDIN_FILENO, &c, sizeof(c)) <= 0)
+        {
+            g_inputOpen = FALSE;
+            break;
+        }
+
+        // Terminals send a carriage return for enter
+        HardwarepUartInput(&g_uart2, '\n' == c ? '\r' : c);
+    }
+}
+
+static
+inline
+VOID
+HardwarepUpdateTimer
+    (
+        IN HARDWARE_TIMER* timer,
+        IN HARDWARE_TIME now
+    )
+{
+    volatile UINT* clear = HARDWARE_REGISTER(timer->base, CLR_OFFSET);
+    UINT control = *HARDWARE_REGISTER(timer->base, CRTL_OFFSET);
+    BOOLEAN enabled = (control & ENABLE_MASK) != 0;
+
+    if(*clear)
+    {
+        timer->pending = FALSE;
+        *clear = 0;
+    }
+
+    if(enabled && !timer->enabled)
+    {
+        timer->start = now;
+        timer->underflows = 0;
+    }
+
+    timer->enabled = enabled;
+
+    if(enabled)
+    {
+        HARDWARE_TIME period = ((HARDWARE_TIME) *HARDWARE_REGISTER(timer->base, LDR_OFFSET)) + 1;
+        HARDWARE_TIME ticks = ((now - timer->start) * TIMER_CLK) / NANOSECONDS_PER_SECOND;
+        HARDWARE_TIME underflows = ticks / period;
+
+        // The timers count down
+        *HARDWARE_REGISTER(timer->base, VAL_OFFSET) = (UINT) (period - 1 - (ticks % period));
+
+        if(underflows != timer->underflows)
+        {
+            timer->underflows = underflows;
+            timer->pending = TRUE;
+        }
+    }
+}
+
+static
+inline
+HARDWARE_TIME
+HardwarepCharacterTime
+    (
+        IN HARDWARE_UART* uart
+    )
+{
+    UINT lineControl = *HARDWARE_REGISTER(uart->base, UART_LCRH_OFFSET);
+    UINT divisor = ((*HARDWARE_REGISTER(uart->base, UART_LCRM_OFFSET) & BRDH_MASK) << 8) |
+                   (*HARDWARE_REGISTER(uart->base, UART_LCRL_OFFSET) & BRDL_MASK);
+    UINT baudRate = UART_CLK / (16 * (divisor + 1));
+    UINT bits = 1 + 8 + (lineControl & STP2_MASK ? 2 : 1) + (lineControl & PEN_MASK ? 1 : 0);
+
+    return (bits * NANOSECONDS_PER_SECOND) / baudRate;
+}
+
+static
+inline
+UINT
+HardwarepUartFifoSize
+    (
+        IN HARDWARE_UART* uart
+    )
+{
+    return (*HARDWARE_REGISTER(uart->base, UART_LCRH_OFFSET) & FEN_MASK) ? HARDWARE_UART_FIFO_SIZE : 1;
+}
+
+static
+inline
+BOOLEAN
+HardwarepSyncUart
+    (
+        IN HARDWARE_UART* uart,
+        IN HARDWARE_TIME now
+    )
+{
+    UINT control = *HARDWARE_REGISTER(uart->base, UART_CTLR_OFFSET);
+    UINT fifoSize = HardwarepUartFifoSize(uart);
+    BOOLEAN fifoEnabled = fifoSize > 1;
+    UINT status = 0;
+
+    if((control & MSIEN_MASK) && uart->modemStatusChanged)
+    {
+        status |= MIS_MASK;
+    }
+
+    // With the fifo on, the receive interrupt waits for it to fill half way.
+    // The timeout picks up anything left behind once the line goes quiet.
+    if((control & RIEN_MASK) &&
+       uart->receiveCount >= (fifoEnabled ? fifoSize / 2 : 1))
+    {
+        status |= RIS_MASK;
+    }
+
+    if((control & RTIEN_MASK) &&
+       fifoEnabled &&
+       uart->receiveCount > 0 &&
+       now >= uart->lastReceived + HARDWARE_UART_TIMEOUT_CHARACTERS * HardwarepCharacterTime(uart))
+    {
+        status |= RTIS_MASK;
+    }
+
+    // The transmit interrupt fires once the fifo is half empty
+    if((control & TIEN_MASK) &&
+       uart->transmitCount <= (fifoEnabled ? fifoSize / 2 : 0))
+    {
+        status |= TIS_MASK;
+    }
+
+    *HARDWARE_REGISTER(uart->base, UART_FLAG_OFFSET) =
+        (0 == uart->receiveCount ? RXFE_MASK : 0) |
+        (fifoSize == uart->receiveCount ? RXFF_MASK : 0) |
+        (0 == uart->transmitCount ? TXFE_MASK : 0) |
+        (fifoSize == uart->transmitCount ? TXFF_MASK : 0) |
+        (uart->transmitting ? TXBUSY_MASK : 0) |
+        (uart->clearToSend ? CTS_MASK : 0);
+
+    uart->status = HARDWARE_LOADED | status;
+    *HARDWARE_REGISTER(uart->base, UART_INTR_OFFSET) = uart->status;
+
+    return status != 0;
+}
+
+static
+inline
+BOOLEAN
+HardwarepUpdateUart
+    (
+        IN HARDWARE_UART* uart,
+        IN HARDWARE_TIME now
+    )
+{
+    volatile UINT* interrupt = HARDWARE_REGISTER(uart->base, UART_INTR_OFFSET);
+    HARDWARE_TIME characterTime = HardwarepCharacterTime(uart);
+
+    // Writing the interrupt register clears the modem status interrupt
+    if(*interrupt != uart->status)
+    {
+        uart->modemStatusChanged = FALSE;
+    }
+
+    // Shift out everything that has had time to go
+    while(uart->transmitting && now >= uart->transmitDone)
+    {
+        uart->output(uart, uart->transmitFifo[uart->transmitStart]);
+        uart->transmitStart = (uart->transmitStart + 1) % HARDWARE_UART_FIFO_SIZE;
+        uart->transmitCount--;
+
+        if(!uart->clearToSend)
+        {
+            uart->clearToSend = TRUE;
+            uart->modemStatusChanged = TRUE;
+        }
+
+        uart->transmitting = uart->transmitCount > 0;
+        uart->transmitDone += characterTime;
+    }
+
+    if(uart->inputCount > 0 &&
+       uart->receiveCount < HardwarepUartFifoSize(uart) &&
+       now >= uart->receiveDone)
+    {
+        UINT index = (uart->receiveStart + uart->receiveCount) % HARDWARE_UART_FIFO_SIZE;
+
+        uart->receiveFifo[index] = uart->input[uart->inputStart];
+        uart->receiveCount++;
+        uart->inputStart = (uart->inputStart + 1) % HARDWARE_INPUT_BUFFER_SIZE;
+        uart->inputCount--;
+        uart->receiveDone = now + characterTime;
+        uart->lastReceived = now;
+    }
+
+    return HardwarepSyncUart(uart, now);
+}
+
+static
+inline
+UINT
+HardwarepUpdateVic
+    (
+        IN UINTPTR vicBase,
+        IN OUT UINT* enabled,
+        IN UINT raw
+    )
+{
+    volatile UINT* enable = HARDWARE_REGISTER(vicBase, VIC_ENABLE_OFFSET);
+    volatile UINT* disable = HARDWARE_REGISTER(vicBase, VIC_DISABLE_OFFSET);
+    UINT status;
+
+    // Software sets bits in the enable register with a read-modify-write, so
+    // only bits that were not already enabled are requests to enable
+    *enabled = (*enabled & ~(*disable)) | (*enable & ~(*enabled));
+    *enable = *enabled;
+    *disable = 0;
+
+    status = raw & *enabled;
+    *HARDWARE_REGISTER(vicBase, VIC_STATUS_OFFSET) = status;
+
+    return status;
+}
+
+BOOLEAN
+HardwareUpdate
+    (
+        VOID
+    )
+{
+    HARDWARE_TIME now = HardwarepNow();
+    UINT vic1Raw = 0;
+    UINT vic2Raw = 0;
+    UINT vic1Status;
+    UINT vic2Status;
+
+    HardwarepPollInput(now);
+
+    HardwarepUpdateTimer(&g_timer2, now);
+    HardwarepUpdateTimer(&g_timer3, now);
+
+    if(g_timer2.pending)
+    {
+        vic1Raw |= TC2IO_MASK;
+    }
+
+    if(HardwarepUpdateUart(&g_uart1, now))
+    {
+        vic2Raw |= UART1_MASK;
+    }
+
+    if(HardwarepUpdateUart(&g_uart2, now))
+    {
+        vic2Raw |= UART2_MASK;
+    }
+
+    vic1Status = HardwarepUpdateVic(VIC1_BASE, &g_vic1Enabled, vic1Raw);
+    vic2Status = HardwarepUpdateVic(VIC2_BASE, &g_vic2Enabled, vic2Raw);
+
+    return (vic1Status | vic2Status) != 0;
+}
+
+static
+inline
+HARDWARE_UART*
+HardwarepFindUart
+    (
+        IN UINTPTR base
+    )
+{
+    ASSERT(UART1_BASE == base || UART2_BASE == base);
+
+    return UART1_BASE == base ? &g_uart1 : &g_uart2;
+}
+
+// Tasks touch the data registers, so keep the interrupt
+// from updating the models underneath them
+static
+inline
+VOID
+HardwarepBlockInterrupts
+    (
+        OUT sigset_t* previousMask
+    )
+{
+    sigset_t mask;
+
+    VERIFY(0 == sigemptyset(&mask));
+    VERIFY(0 == sigaddset(&mask, SIGALRM));
+    VERIFY(0 == sigprocmask(SIG_BLOCK, &mask, previousMask));
+}
+
+unsigned int
+HardwareUartReadData
+    (
+        unsigned long base
+    )
+{
+    HARDWARE_UART* uart = HardwarepFindUart(base);
+    sigset_t previousMask;
+    UINT data = 0;
+
+    HardwarepBlockInterrupts(&previousMask);
+
+    if(uart->receiveCount > 0)
+    {
+        data = uart->receiveFifo[uart->receiveStart];
+        uart->receiveStart = (uart->receiveStart + 1) % HARDWARE_UART_FIFO_SIZE;
+        uart->receiveCount--;
+    }
+
+    HardwarepSyncUart(uart, HardwarepNow());
+
+    VERIFY(0 == sigprocmask(SIG_SETMASK, &previousMask, NULL));
+
+    return data;
+}
+
+void
+HardwareUartWriteData
+    (
+        unsigned long base,
+        unsigned int data
+    )
+{
+    HARDWARE_UART* uart = HardwarepFindUart(base);
+    sigset_t previousMask;
+    HARDWARE_TIME now;
+
+    HardwarepBlockInterrupts(&previousMask);
+
+    now = HardwarepNow();
+
+    // A full fifo drops the character, like the real one
+    if(uart->transmitCount < HardwarepUartFifoSize(uart))
+    {
+        UINT index = (uart->transmitStart + uart->transmitCount) % HARDWARE_UART_FIFO_SIZE;
+
+        uart->transmitFifo[index] = data & DATA_MASK;
+        uart->transmitCount++;
+
+        if(!uart->transmitting)
+        {
+            uart->transmitting = TRUE;
+            uart->transmitDone = now + HardwarepCharacterTime(uart);
+        }
+
+        if(uart->flowControl)
+        {
+            uart->clearToSend = FALSE;
+        }
+    }
+
+    HardwarepSyncUart(uart, now);
+
+    VERIFY(0 == sigprocmask(SIG_SETMASK, &previousMask, NULL));
+}
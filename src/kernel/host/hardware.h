@@ -0,0 +1,17 @@
+#pragma once
+
+#include <rt.h>
+
+VOID
+HardwareInit
+    (
+        VOID
+    );
+
+// Brings the timer, uart and interrupt controller registers up to date.
+// Returns TRUE if the interrupt controller has a pending interrupt.
+BOOLEAN
+HardwareUpdate
+    (
+        VOID
+    );
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <rt.h>
+#include <rtkernel.h>
+#include <signal.h>
+#include <ucontext.h>
+#include "stack.h"
+
+// Room below a trap frame for async parameters
+#define TRAP_FRAME_PARAMETER_SIZE 128
+#define TRAP_FRAME_NUM_ARGUMENTS 5
+
+// The host equivalent of the registers that trap.asm and interrupt.asm
+// push on to a task's stack.  A task's stack pointer points at pc so that
+// the return value lands at the same offset as the board's r0.
+typedef struct _TRAP_FRAME
+{
+    UCHAR parameters[TRAP_FRAME_PARAMETER_SIZE];
+    UINT pc;
+    UINT cpsr;
+    INT r0;
+    BOOLEAN interrupt;
+    UINT systemCall;
+    UINTPTR arguments[TRAP_FRAME_NUM_ARGUMENTS];
+    TASK_START_FUNC startFunc;
+    PVOID argument;     // Passed to startFunc unless it is NULL
+    ucontext_t context;
+} TRAP_FRAME;
+
+typedef INT (*SYSTEM_CALL)(UINTPTR, UINTPTR, UINTPTR, UINTPTR, UINTPTR);
+
+// Set while the kernel owns the processor.  Interrupts that arrive while it
+// is set are deferred until the kernel returns to a task.
+extern volatile sig_atomic_t g_kernelActive;
+extern volatile sig_atomic_t g_interruptDeferred;
+
+extern PVOID g_systemCallTable[];
+
+static
+inline
+TRAP_FRAME*
+TrapGetFrame
+    (
+        IN UINT* stackPointer
+    )
+{
+    return container_of(stackPointer, TRAP_FRAME, pc);
+}
+
+// Builds the first trap frame just below stackEnd
+UINT*
+TrapSetupStack
+    (
+        IN STACK* stack,
+        IN PVOID stackEnd,
+        IN TASK_START_FUNC startFunc,
+        IN PVOID argument
+    );
+
+INT
+TrapEnter
+    (
+        IN UINT systemCall,
+        IN UINTPTR arg0,
+        IN UINTPTR arg1,
+        IN UINTPTR arg2,
+        IN UINTPTR arg3,
+        IN UINTPTR arg4
+    );
+
+VOID
+InterruptEnter
+    (
+        VOID
+    );
+
+VOID
+InterruptHandler
+    (
+        VOID
+    );
+
+VOID
+KernelEnter
+    (
+        IN TRAP_FRAME* frame
+    );
+
+VOID
+KernelResumeTask
+    (
+        VOID
+    );
@@ -0,0 +1,74 @@
+#include "host.h"
+
+#include <rtosc/assert.h>
+#include <sys/time.h>
+#include "hardware.h"
+
+// Interval at which the hardware models are checked for interrupts
+#define INTERRUPT_POLL_INTERVAL_US 100
+
+static
+VOID
+InterruptpSignalHandler
+    (
+        INT signal
+    )
+{
+    if(g_kernelActive)
+    {
+        g_interruptDeferred = TRUE;
+    }
+    else
+    {
+        InterruptEnter();
+    }
+}
+
+VOID
+InterruptInstallHandler
+    (
+        VOID
+    )
+{
+    struct sigaction action;
+    struct itimerval timer;
+    sigset_t mask;
+
+    HardwareInit();
+
+    // The kernel runs with interrupts disabled
+    VERIFY(0 == sigemptyset(&mask));
+    VERIFY(0 == sigaddset(&mask, SIGALRM));
+    VERIFY(0 == sigprocmask(SIG_BLOCK, &mask, NULL));
+
+    action.sa_handler = InterruptpSignalHandler;
+    action.sa_mask = mask;
+    action.sa_flags = SA_RESTART;
+    VERIFY(0 == sigaction(SIGALRM, &action, NULL));
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = INTERRUPT_POLL_INTERVAL_US;
+    timer.it_value = timer.it_interval;
+    VERIFY(0 == setitimer(ITIMER_REAL, &timer, NULL));
+}
+
+VOID
+InterruptEnter
+    (
+        VOID
+    )
+{
+    TRAP_FRAME frame;
+
+    g_kernelActive = TRUE;
+
+    if(HardwareUpdate())
+    {
+        frame.interrupt = TRUE;
+        KernelEnter(&frame);
+    }
+    else
+    {
+        g_kernelActive = FALSE;
+    }
+}
@@ -0,0 +1,95 @@
+#include "host.h"
+
+#include <rtosc/assert.h>
+#include "hardware.h"
+#include "scheduler.h"
+#include "syscall.h"
+#include <ts7200.h>
+
+volatile sig_atomic_t g_kernelActive = TRUE;
+volatile sig_atomic_t g_interruptDeferred = FALSE;
+
+static ucontext_t g_kernelContext;
+
+static
+inline
+VOID
+KernelpHandleTrap
+    (
+        IN TRAP_FRAME* frame
+    )
+{
+    if(frame->interrupt)
+    {
+        InterruptHandler();
+    }
+    else
+    {
+        SYSTEM_CALL systemCall = (SYSTEM_CALL) g_systemCallTable[frame->systemCall];
+
+        g_lastSystemCall = frame->systemCall;
+        g_lastSystemCallTicks = *(volatile UINT*) (TIMER3_BASE + VAL_OFFSET);
+
+        frame->r0 = systemCall(frame->arguments[0],
+                               frame->arguments[1],
+                               frame->arguments[2],
+                               frame->arguments[3],
+                               frame->arguments[4]);
+    }
+}
+
+VOID
+KernelLeave
+    (
+        IN UINT* stack
+    )
+{
+    TRAP_FRAME* frame;
+
+    // On the board an interrupt that became pending while the kernel was
+    // running fires as soon as the task is resumed.  Take it right away
+    // instead of paying for two context switches.
+    if(HardwareUpdate())
+    {
+        InterruptHandler();
+        return;
+    }
+
+    // Return to user mode
+    VERIFY(0 == swapcontext(&g_kernelContext, &TrapGetFrame(stack)->context));
+
+    // The task trapped back in to the kernel and left a new frame behind
+    frame = TrapGetFrame(SchedulerGetCurrentTask()->stackPointer);
+
+    HardwareUpdate();
+    KernelpHandleTrap(frame);
+}
+
+VOID
+KernelEnter
+    (
+        IN TRAP_FRAME* frame
+    )
+{
+    ASSERT(g_kernelActive);
+
+    SchedulerGetCurrentTask()->stackPointer = &frame->pc;
+    VERIFY(0 == swapcontext(&frame->context, &g_kernelContext));
+
+    KernelResumeTask();
+}
+
+VOID
+KernelResumeTask
+    (
+        VOID
+    )
+{
+    g_kernelActive = FALSE;
+
+    while(g_interruptDeferred)
+    {
+        g_interruptDeferred = FALSE;
+        InterruptEnter();
+    }
+}
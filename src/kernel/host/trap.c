@@ -0,0 +1,120 @@
+#include "host.h"
+
+#include <rtosc/assert.h>
+#include "scheduler.h"
+#include "trap.h"
+
+VOID
+TrapInstallHandler
+    (
+        VOID
+    )
+{
+    // System calls are made by calling TrapEnter directly
+}
+
+static
+VOID
+TrappTaskStart
+    (
+        VOID
+    )
+{
+    TRAP_FRAME* frame = TrapGetFrame(SchedulerGetCurrentTask()->stackPointer);
+    TASK_START_FUNC startFunc = frame->startFunc;
+    PVOID argument = frame->argument;
+
+    KernelResumeTask();
+
+    if(NULL == argument)
+    {
+        startFunc();
+    }
+    else
+    {
+        ((TASK_START_ARG_FUNC) startFunc)(argument);
+    }
+
+    Exit();
+}
+
+UINT*
+TrapSetupStack
+    (
+        IN STACK* stack,
+        IN PVOID stackEnd,
+        IN TASK_START_FUNC startFunc,
+        IN PVOID argument
+    )
+{
+    TRAP_FRAME* frame = ((TRAP_FRAME*) stackEnd) - 1;
+    PVOID stackBottom = stack->top + 1;
+
+    frame->startFunc = startFunc;
+    frame->argument = argument;
+
+    // The task inherits the kernel's signal mask, but unlike the kernel
+    // it must be interruptible
+    VERIFY(0 == getcontext(&frame->context));
+    VERIFY(0 == sigdelset(&frame->context.uc_sigmask, SIGALRM));
+
+    frame->context.uc_link = NULL;
+    frame->context.uc_stack.ss_sp = stackBottom;
+    frame->context.uc_stack.ss_size = ((UINTPTR) frame) - ((UINTPTR) stackBottom);
+    makecontext(&frame->context, TrappTaskStart, 0);
+
+    return &frame->pc;
+}
+
+INT
+TrapEnter
+    (
+        IN UINT systemCall,
+        IN UINTPTR arg0,
+        IN UINTPTR arg1,
+        IN UINTPTR arg2,
+        IN UINTPTR arg3,
+        IN UINTPTR arg4
+    )
+{
+    TRAP_FRAME frame;
+
+#ifndef NTRAP_FAST_PATH
+    TASK_DESCRIPTOR* td = SchedulerGetCurrentTask();
+
+    // Like trap.asm, answer the system calls that neither
+    // block nor reschedule without going in to the kernel
+    switch(systemCall)
+    {
+        case MyTidSystemCall:
+            return td->taskId;
+
+        case MyParentTidSystemCall:
+            return td->parentTaskId;
+
+        case PassSystemCall:
+            if(SchedulerIsCurrentTaskNext())
+            {
+                return 0;
+            }
+            break;
+
+        default:
+            break;
+    }
+#endif
+
+    g_kernelActive = TRUE;
+
+    frame.interrupt = FALSE;
+    frame.systemCall = systemCall;
+    frame.arguments[0] = arg0;
+    frame.arguments[1] = arg1;
+    frame.arguments[2] = arg2;
+    frame.arguments[3] = arg3;
+    frame.arguments[4] = arg4;
+
+    KernelEnter(&frame);
+
+    return frame.r0;
+}
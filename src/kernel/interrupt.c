@@ -1,11 +1,17 @@
 #include "interrupt.h"
 
 #include <rtosc/assert.h>
+#include <rtosc/buffer.h>
+#include "clock.h"
+#include "performance.h"
 #include "scheduler.h"
+#include "task.h"
+#include "trace.h"
 #include <ts7200.h>
 
 #define TIMER_CONTROL(timerBase) ((volatile UINT*)(ptr_add(timerBase, CRTL_OFFSET)))
 #define TIMER_LOAD(timerBase) ((volatile UINT*)(ptr_add(timerBase, LDR_OFFSET)))
+#define TIMER_CLEAR(timerBase) ((volatile UINT*)(ptr_add(timerBase, CLR_OFFSET)))
 
 #define UART_LCRH(uartBase) ((volatile UINT*) (ptr_add(uartBase, UART_LCRH_OFFSET)))
 #define UART_LCRM(uartBase) ((volatile UINT*) (ptr_add(uartBase, UART_LCRM_OFFSET)))
@@ -15,8 +21,6 @@
 #define UART_INTR(uartBase) ((volatile UINT*) (ptr_add(uartBase, UART_INTR_OFFSET)))
 #define UART_CTS(uartBase) (*UART_FLAG(uartBase) & CTS_MASK)
 
-#define VIC1_BASE 0x800B0000
-#define VIC2_BASE 0x800C0000
 #define STATUS_OFFSET 0
 #define ENABLE_OFFSET 0x10
 #define DISABLE_OFFSET 0x14
@@ -31,6 +35,9 @@
 
 #define UART_CLK 7372800
 
+// Characters received while nobody was in AwaitEventData()
+#define EVENT_DATA_BUFFER_SIZE 256
+
 extern
 VOID
 InterruptInstallHandler
@@ -38,7 +45,25 @@ InterruptInstallHandler
         VOID
     );
 
-static TASK_DESCRIPTOR* g_eventHandlers[NumEvent];
+// Tasks blocked in AwaitEvent(), in the order they started waiting
+typedef struct _EVENT_WAITERS
+{
+    TASK_DESCRIPTOR* head;
+    TASK_DESCRIPTOR* tail;
+} EVENT_WAITERS;
+
+// Kept on an AwaitEventData() blocked task's stack until data arrives
+typedef struct _PENDING_EVENT_DATA
+{
+    PVOID buffer;
+    UINT bufferLength;
+} PENDING_EVENT_DATA;
+
+static EVENT_WAITERS g_eventWaiters[NumEvent];
+static UINT g_pendingEvents[NumEvent];  // Fired while nobody was waiting
+static UCHAR g_underlyingEventData[NumEvent][EVENT_DATA_BUFFER_SIZE];
+static RT_CIRCULAR_BUFFER g_eventData[NumEvent];
+static UINT g_interruptTicks;
 static volatile BOOLEAN g_clearToSend;
 static volatile BOOLEAN g_transmitReady;
 
@@ -65,7 +90,7 @@ InterruptpDisable
             break;
 
         case UartCom2ReceiveEvent:
-            *UART_CTRL((UINT*) UART2_BASE) &= ~RIEN_MASK;
+            *UART_CTRL((UINT*) UART2_BASE) &= ~(RIEN_MASK | RTIEN_MASK);
             break;
 
         case UartCom2TransmitEvent:
@@ -101,7 +126,7 @@ InterruptpEnable
             break;
 
         case UartCom2ReceiveEvent:
-            *UART_CTRL((UINT*) UART2_BASE) |= RIEN_MASK;
+            *UART_CTRL((UINT*) UART2_BASE) |= RIEN_MASK | RTIEN_MASK;
             break;
 
         case UartCom2TransmitEvent:
@@ -116,21 +141,130 @@ InterruptpEnable
 
 static
 inline
-VOID
-InterruptpSignalEvent
+BOOLEAN
+InterruptpIsLevelTriggered
     (
         IN EVENT event
     )
 {
-    TASK_DESCRIPTOR* handler = g_eventHandlers[event];
+    // The kernel acknowledges the timer and drains the receivers itself.
+    // The transmitters keep interrupting until a handler writes more data.
+    return UartCom1TransmitEvent == event || UartCom2TransmitEvent == event;
+}
+
+static
+inline
+BOOLEAN
+InterruptpHasData
+    (
+        IN EVENT event
+    )
+{
+    return UartCom1ReceiveEvent == event || UartCom2ReceiveEvent == event;
+}
+
+static
+inline
+VOID
+InterruptpWakeHandler
+    (
+        IN TASK_DESCRIPTOR* handler,
+        IN EVENT event,
+        IN INT returnValue
+    )
+{
+    TraceRecordAt(TraceEventWakeup, handler->taskId, event, g_interruptTicks);
+
+    // The kernel finishes timing the latency once the handler runs
+    handler->wokenEvent = event;
+    handler->wokenTicks = g_interruptTicks;
 
     // Unblock the handler
+    handler->nextEventWaiter = NULL;
     handler->state = ReadyState;
-    TaskSetReturnValue(handler, STATUS_SUCCESS);
+    TaskSetReturnValue(handler, returnValue);
     SchedulerAddTask(handler);
+}
+
+static
+inline
+VOID
+InterruptpDeliverData
+    (
+        IN EVENT event
+    )
+{
+    RT_CIRCULAR_BUFFER* data = &g_eventData[event];
+
+    // Hand out the data in the order the handlers started waiting
+    while(NULL != g_eventWaiters[event].head && !RtCircularBufferIsEmpty(data))
+    {
+        TASK_DESCRIPTOR* handler = g_eventWaiters[event].head;
+        PENDING_EVENT_DATA* pendingData = TaskGetAsyncParameter(handler, sizeof(*pendingData));
+        UINT length = min(RtCircularBufferSize(data), pendingData->bufferLength);
 
-    // Clear the handler
-    g_eventHandlers[event] = NULL;
+        g_eventWaiters[event].head = handler->nextEventWaiter;
+
+        if(NULL == g_eventWaiters[event].head)
+        {
+            g_eventWaiters[event].tail = NULL;
+        }
+
+        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(data, pendingData->buffer, length)));
+        InterruptpWakeHandler(handler, event, length);
+    }
+}
+
+static
+inline
+VOID
+InterruptpSignalEvent
+    (
+        IN EVENT event
+    )
+{
+    TASK_DESCRIPTOR* handler = g_eventWaiters[event].head;
+
+    if(NULL == handler)
+    {
+        // Nobody is waiting.  Hold on to the event for the next AwaitEvent().
+        g_pendingEvents[event]++;
+        return;
+    }
+
+    g_eventWaiters[event].head = NULL;
+    g_eventWaiters[event].tail = NULL;
+
+    // Wake every waiter
+    while(NULL != handler)
+    {
+        TASK_DESCRIPTOR* next = handler->nextEventWaiter;
+
+        InterruptpWakeHandler(handler, event, 1);
+
+        handler = next;
+    }
+}
+
+static
+inline
+VOID
+InterruptpReceive
+    (
+        IN EVENT event,
+        IN UINTPTR uartBase
+    )
+{
+    // Empty the receiver so the interrupt goes away
+    while(!(*UART_FLAG(uartBase) & RXFE_MASK))
+    {
+        UCHAR c = UART_READ_DATA(uartBase);
+
+        // Drop the character if nobody has collected the last 256, like an overrun
+        (VOID) RtCircularBufferPush(&g_eventData[event], &c, sizeof(c));
+    }
+
+    InterruptpDeliverData(event);
 }
 
 static
@@ -144,8 +278,11 @@ InterruptpHandleEvent
     // Handle the interrupt
     InterruptpSignalEvent(event);
 
-    // Disable the interrupt
-    InterruptpDisable(event);
+    // Level triggered interrupts stay off until someone deals with the data
+    if(InterruptpIsLevelTriggered(event))
+    {
+        InterruptpDisable(event);
+    }
 }
 
 VOID
@@ -154,9 +291,17 @@ InterruptHandler
         VOID
     )
 {
+    g_interruptTicks = *(volatile UINT*) (TIMER3_BASE + VAL_OFFSET);
+    TraceRecordAt(TraceInterrupt, SchedulerGetCurrentTask()->taskId, 0, g_interruptTicks);
+
     if(*VIC_STATUS(VIC1_BASE) & TC2IO_MASK)
     {
+        // Acknowledge the interrupt
+        *TIMER_CLEAR((UINT*) TIMER2_BASE) = TRUE;
+
         InterruptpHandleEvent(ClockEvent);
+        ClockTick();
+        PerformanceTick();
     }
     else if(*VIC_STATUS(VIC2_BASE) & UART2_MASK)
     {
@@ -167,9 +312,10 @@ InterruptHandler
             InterruptpHandleEvent(UartCom2TransmitEvent);
         }
 
-        if(uart2Status & RIS_MASK)
+        // The fifo raises a timeout for characters that never filled it half way
+        if(uart2Status & (RIS_MASK | RTIS_MASK))
         {
-            InterruptpHandleEvent(UartCom2ReceiveEvent);
+            InterruptpReceive(UartCom2ReceiveEvent, UART2_BASE);
         }
     }
     else if(*VIC_STATUS(VIC2_BASE) & UART1_MASK)
@@ -193,7 +339,7 @@ InterruptHandler
 
         if(uart1Status & RIS_MASK)
         {
-            InterruptpHandleEvent(UartCom1ReceiveEvent);
+            InterruptpReceive(UartCom1ReceiveEvent, UART1_BASE);
         }
 
         if(g_clearToSend && g_transmitReady)
@@ -233,7 +379,8 @@ InterruptpSetupUart
         IN UINT* uartBase, 
         IN UINT vicMask,
         IN UINT baudRate, 
-        IN BOOLEAN needsTwoStopBits
+        IN BOOLEAN needsTwoStopBits,
+        IN BOOLEAN useFifo
     )
 {
     // Setup the baud rate
@@ -242,8 +389,17 @@ InterruptpSetupUart
     *UART_LCRL(uartBase) = baudRateDivisor & 0xFF;
 
     // Setup the uart
-    // Disable FIFO and parity bits
-    *UART_LCRH(uartBase) &= ~(FEN_MASK | PEN_MASK);
+    // Disable parity bits
+    *UART_LCRH(uartBase) &= ~PEN_MASK;
+
+    if(useFifo)
+    {
+        *UART_LCRH(uartBase) |= FEN_MASK;
+    }
+    else
+    {
+        *UART_LCRH(uartBase) &= ~FEN_MASK;
+    }
 
     if(needsTwoStopBits)
     {
@@ -269,7 +425,10 @@ InterruptInit
 
     for(i = 0; i < NumEvent; i++)
     {
-        g_eventHandlers[i] = NULL;
+        g_eventWaiters[i].head = NULL;
+        g_eventWaiters[i].tail = NULL;
+        g_pendingEvents[i] = 0;
+        RtCircularBufferInit(&g_eventData[i], g_underlyingEventData[i], sizeof(g_underlyingEventData[i]));
     }
 
     g_clearToSend = UART_CTS((UINT*) UART1_BASE);
@@ -277,8 +436,13 @@ InterruptInit
 
     InterruptInstallHandler();
     InterruptpSetupTimer((UINT*) TIMER2_BASE);
-    InterruptpSetupUart((UINT*) UART1_BASE, UART1_MASK, 2400, TRUE);
-    InterruptpSetupUart((UINT*) UART2_BASE, UART2_MASK, 115200, FALSE);
+    InterruptpEnable(ClockEvent);
+    InterruptpEnable(UartCom1ReceiveEvent);
+    InterruptpEnable(UartCom2ReceiveEvent);
+    // The train controller needs clear to send between every byte, so COM1
+    // can't use its fifo.  COM2 moves up to a fifo's worth per interrupt.
+    InterruptpSetupUart((UINT*) UART1_BASE, UART1_MASK, 2400, TRUE, FALSE);
+    InterruptpSetupUart((UINT*) UART2_BASE, UART2_MASK, 115200, FALSE, TRUE);
 }
 
 VOID
@@ -309,36 +473,99 @@ InterruptpIsValidEvent
     return ClockEvent <= event && event < NumEvent;
 }
 
-static
-inline
-BOOLEAN
-InterruptpIsEventAvailable
+RT_STATUS
+InterruptAwaitEvent
     (
-        IN EVENT event
+        IN TASK_DESCRIPTOR* td,
+        IN EVENT event,
+        OUT UINT* pendingEvents
     )
 {
-    return g_eventHandlers[event] == NULL;
+    // Events that carry data go through AwaitEventData()
+    if(!InterruptpIsValidEvent(event) || InterruptpHasData(event))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    *pendingEvents = g_pendingEvents[event];
+
+    if(*pendingEvents > 0)
+    {
+        // The event already happened, so there is no need to block
+        g_pendingEvents[event] = 0;
+        return STATUS_SUCCESS;
+    }
+
+    td->state = EventBlockedState;
+    td->nextEventWaiter = NULL;
+
+    if(NULL == g_eventWaiters[event].head)
+    {
+        g_eventWaiters[event].head = td;
+
+        if(InterruptpIsLevelTriggered(event))
+        {
+            InterruptpEnable(event);
+        }
+    }
+    else
+    {
+        g_eventWaiters[event].tail->nextEventWaiter = td;
+    }
+
+    g_eventWaiters[event].tail = td;
+
+    return STATUS_SUCCESS;
 }
 
 RT_STATUS
-InterruptAwaitEvent
+InterruptAwaitEventData
     (
         IN TASK_DESCRIPTOR* td,
-        IN EVENT event
+        IN EVENT event,
+        IN PVOID buffer,
+        IN UINT bufferLength,
+        OUT UINT* bytesRead
     )
 {
-    if(InterruptpIsValidEvent(event) &&
-       InterruptpIsEventAvailable(event))
+    RT_CIRCULAR_BUFFER* data;
+
+    if(!InterruptpIsValidEvent(event) || !InterruptpHasData(event))
     {
-        g_eventHandlers[event] = td;
-        td->state = EventBlockedState;
-        InterruptpEnable(event);
+        return STATUS_INVALID_PARAMETER;
+    }
 
-        return STATUS_SUCCESS;
+    data = &g_eventData[event];
+
+    if(!RtCircularBufferIsEmpty(data))
+    {
+        // Data is already waiting, so there is no need to block
+        *bytesRead = min(RtCircularBufferSize(data), bufferLength);
+        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(data, buffer, *bytesRead)));
     }
     else
     {
-        ASSERT(FALSE);
-        return STATUS_INVALID_PARAMETER;
+        PENDING_EVENT_DATA* pendingData = TaskGetAsyncParameter(td, sizeof(*pendingData));
+
+        pendingData->buffer = buffer;
+        pendingData->bufferLength = bufferLength;
+
+        td->state = EventBlockedState;
+        td->nextEventWaiter = NULL;
+
+        if(NULL == g_eventWaiters[event].head)
+        {
+            g_eventWaiters[event].head = td;
+        }
+        else
+        {
+            g_eventWaiters[event].tail->nextEventWaiter = td;
+        }
+
+        g_eventWaiters[event].tail = td;
+
+        *bytesRead = 0;
     }
+
+    return STATUS_SUCCESS;
 }
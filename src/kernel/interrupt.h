@@ -20,5 +20,16 @@ RT_STATUS
 InterruptAwaitEvent
     (
         IN TASK_DESCRIPTOR* td,
-        IN EVENT event
+        IN EVENT event,
+        OUT UINT* pendingEvents
+    );
+
+RT_STATUS
+InterruptAwaitEventData
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN EVENT event,
+        IN PVOID buffer,
+        IN UINT bufferLength,
+        OUT UINT* bytesRead
     );
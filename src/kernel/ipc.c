@@ -1,18 +1,25 @@
 #include "ipc.h"
 
+#include <rtosc/assert.h>
 #include <rtosc/string.h>
+#include "clock.h"
+#include "performance.h"
 #include "scheduler.h"
 
 #define ERROR_TRANSACTION_NOT_FINISHED -3
 
-#define MAILBOX_SIZE NUM_TASKS
+// Messages up to this many words skip RtMemcpy
+#define IPC_FAST_PATH_WORDS 4
 
-typedef struct _PENDING_MESSAGE 
+// Kept on a Send() blocked task's stack until the
+// message is received and the reply comes back
+typedef struct _PENDING_SEND
 {
-    TASK_DESCRIPTOR* from;
     PVOID message;
     INT messageLength;
-} PENDING_MESSAGE;
+    PVOID replyBuffer;
+    INT replyBufferLength;
+} PENDING_SEND;
 
 typedef struct _PENDING_RECEIVE
 {
@@ -21,7 +28,149 @@ typedef struct _PENDING_RECEIVE
     INT bufferLength;
 } PENDING_RECEIVE;
 
-static PENDING_MESSAGE g_mailboxes[NUM_TASKS][MAILBOX_SIZE];
+static IPC_MESSAGE g_messages[IPC_NUM_MESSAGES];
+static IPC_MESSAGE* g_freeMessages;
+
+static
+inline
+VOID
+IpcpFreeMessage
+    (
+        IN IPC_MESSAGE* ipcMessage
+    )
+{
+    ipcMessage->next = g_freeMessages;
+    g_freeMessages = ipcMessage;
+}
+
+static
+inline
+VOID
+IpcpCopyMessage
+    (
+        IN PVOID dest,
+        IN PVOID src,
+        IN INT length
+    )
+{
+    // Most messages in the system are a handful of words.  Move those
+    // through registers instead of paying for RtMemcpy's setup.
+    if(length <= IPC_FAST_PATH_WORDS * sizeof(UINT) &&
+       0 == (((UINTPTR) dest | (UINTPTR) src | length) & (sizeof(UINT) - 1)))
+    {
+        UINT* d = (UINT*) dest;
+        UINT* s = (UINT*) src;
+
+        switch(length / sizeof(UINT))
+        {
+            case 4:
+                d[3] = s[3];
+            case 3:
+                d[2] = s[2];
+            case 2:
+                d[1] = s[1];
+            case 1:
+                d[0] = s[0];
+            default:
+                break;
+        }
+    }
+    else
+    {
+        RtMemcpy(dest, src, length);
+    }
+}
+
+static
+inline
+VOID
+IpcpUpdatePriority
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    TASK_PRIORITY priority = td->basePriority;
+
+    if(td->inheritPriority && td->clientPriorities > priority)
+    {
+        priority = SchedulerHighestPriority(td->clientPriorities);
+    }
+
+    if(priority != td->priority)
+    {
+        SchedulerSetPriority(td, priority);
+    }
+}
+
+// The sender's priority counts toward the receiver's
+// from Send() until the receiver replies
+static
+inline
+VOID
+IpcpDonatePriority
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN TASK_DESCRIPTOR* to
+    )
+{
+    TASK_PRIORITY priority = from->priority;
+
+    // A task that outranks the receiver is now waiting on it.  Only
+    // count the receiver's time in the ready queue from here on.
+    if(ReadyState == to->state &&
+       priority > to->basePriority &&
+       to->clientPriorities <= to->basePriority)
+    {
+        PerformanceSetTaskState(to->taskId, ReadyState);
+    }
+
+    from->server = to;
+    from->donatedPriority = priority;
+
+    to->clientCounts[SchedulerPriorityIndex(priority)]++;
+    to->clientPriorities |= priority;
+
+    IpcpUpdatePriority(to);
+}
+
+static
+inline
+VOID
+IpcpReleasePriority
+    (
+        IN TASK_DESCRIPTOR* from
+    )
+{
+    TASK_DESCRIPTOR* server = from->server;
+    UINT index = SchedulerPriorityIndex(from->donatedPriority);
+
+    from->server = NULL;
+
+    // IpcDrainMailbox() takes back what was donated to a task that exits
+    ASSERT(server->clientCounts[index] > 0);
+
+    if(0 == --server->clientCounts[index])
+    {
+        server->clientPriorities &= ~from->donatedPriority;
+        IpcpUpdatePriority(server);
+    }
+}
+
+VOID
+IpcInit
+    (
+        VOID
+    )
+{
+    UINT i;
+
+    g_freeMessages = NULL;
+
+    for(i = 0; i < IPC_NUM_MESSAGES; i++)
+    {
+        IpcpFreeMessage(&g_messages[i]);
+    }
+}
 
 VOID
 IpcInitializeMailbox
@@ -29,10 +178,24 @@ IpcInitializeMailbox
         IN TASK_DESCRIPTOR* td
     )
 {
-    INT mailboxIndex = td->taskId % NUM_TASKS;
-    RtCircularBufferInit(&td->mailbox,
-                         g_mailboxes[mailboxIndex],
-                         sizeof(g_mailboxes[mailboxIndex]));
+    td->mailboxHead = NULL;
+    td->mailboxTail = NULL;
+    td->messageHead = NULL;
+    td->messageTail = NULL;
+    td->messageCount = 0;
+    td->clientPriorities = 0;
+    td->server = NULL;
+    RtMemset(td->clientCounts, sizeof(td->clientCounts), 0);
+}
+
+VOID
+IpcEnablePriorityInheritance
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    td->inheritPriority = TRUE;
+    IpcpUpdatePriority(td);
 }
 
 VOID
@@ -41,23 +204,56 @@ IpcDrainMailbox
         IN TASK_DESCRIPTOR* td
     )
 {
-    while(!RtCircularBufferIsEmpty(&td->mailbox))
+    while(NULL != td->mailboxHead)
+    {
+        TASK_DESCRIPTOR* from = td->mailboxHead;
+
+        td->mailboxHead = from->nextSender;
+        from->server = NULL;
+
+        // The Send-Receive-Reply transaction could not be completed
+        TaskSetReturnValue(from, ERROR_TRANSACTION_NOT_FINISHED);
+        from->state = ReadyState;
+        SchedulerAddTask(from);
+    }
+
+    td->mailboxTail = NULL;
+
+    // Nobody is left to reply to tasks still waiting on this one.  They
+    // stop counting toward it, so the slot's next owner starts clean.
+    if(0 != td->clientPriorities)
     {
-        PENDING_MESSAGE pendingMessage;
-        RT_STATUS status = RtCircularBufferPeekAndPop(&td->mailbox,
-                                                        &pendingMessage,
-                                                        sizeof(pendingMessage));
+        UINT i;
 
-        if(RT_SUCCESS(status))
+        for(i = 0; i < NUM_TASKS; i++)
         {
-            TASK_DESCRIPTOR* from = pendingMessage.from;
+            TASK_DESCRIPTOR* client = TaskDescriptorGetSlot(i);
+
+            if(td == client->server)
+            {
+                client->server = NULL;
 
-            // The Send-Receive-Reply transaction could not be completed
-            TaskSetReturnValue(from, ERROR_TRANSACTION_NOT_FINISHED);
-            from->state = ReadyState;
-            SchedulerAddTask(from);
+                TaskSetReturnValue(client, ERROR_TRANSACTION_NOT_FINISHED);
+                client->state = ReadyState;
+                SchedulerAddTask(client);
+            }
         }
+
+        td->clientPriorities = 0;
+        RtMemset(td->clientCounts, sizeof(td->clientCounts), 0);
     }
+
+    // Nobody is waiting on a posted message, so just drop them
+    while(NULL != td->messageHead)
+    {
+        IPC_MESSAGE* ipcMessage = td->messageHead;
+
+        td->messageHead = ipcMessage->next;
+        IpcpFreeMessage(ipcMessage);
+    }
+
+    td->messageTail = NULL;
+    td->messageCount = 0;
 }
 
 RT_STATUS
@@ -71,26 +267,37 @@ IpcSend
         IN INT replyBufferLength
     )
 {
+    PENDING_SEND* pendingSend = TaskGetAsyncParameter(from, sizeof(*pendingSend));
     RT_STATUS status;
 
+    pendingSend->replyBuffer = replyBuffer;
+    pendingSend->replyBufferLength = replyBufferLength;
+
+    IpcpDonatePriority(from, to);
+
     if(to->state == SendBlockedState)
     {
-        PENDING_RECEIVE pendingReceive;
+        PENDING_RECEIVE* pendingReceive = TaskGetAsyncParameter(to, sizeof(*pendingReceive));
         INT length;
 
-        TaskRetrieveAsyncParameter(to, &pendingReceive, sizeof(pendingReceive));
-        
         // Figure out how many bytes we actually want to copy
         // TODO: We should probably do something if there are excess bytes
-        length = min(messageLength, pendingReceive.bufferLength);
+        length = min(messageLength, pendingReceive->bufferLength);
 
         // Perform the copy
-        RtMemcpy(pendingReceive.buffer, message, length);
+        IpcpCopyMessage(pendingReceive->buffer, message, length);
+        PerformanceGetCounters(from->taskId)->bytesSent += length;
+        PerformanceGetCounters(to->taskId)->bytesReceived += length;
 
         // Finish the Receive() system call
-        *(pendingReceive.senderId) = from->taskId;
+        *(pendingReceive->senderId) = from->taskId;
         TaskSetReturnValue(to, length);
 
+        if(to->timeoutPending)
+        {
+            ClockCancelTimeout(to);
+        }
+
         // Update states and reschedule the target task
         from->state = ReplyBlockedState;
         to->state = ReadyState;
@@ -98,20 +305,24 @@ IpcSend
     }
     else
     {
-        PENDING_MESSAGE pendingMessage = { from, message, messageLength };
+        // The message stays where the sender put it until it is received
+        pendingSend->message = message;
+        pendingSend->messageLength = messageLength;
 
-        // Store the message so it can be picked up later
         from->state = ReceiveBlockedState;
-        status = RtCircularBufferPush(&to->mailbox,
-                                      &pendingMessage,
-                                      sizeof(pendingMessage));
-    }
+        from->nextSender = NULL;
 
-    if(RT_SUCCESS(status))
-    {
-        PENDING_RECEIVE pendingReceive = { NULL, replyBuffer, replyBufferLength };
+        if(NULL == to->mailboxHead)
+        {
+            to->mailboxHead = from;
+        }
+        else
+        {
+            to->mailboxTail->nextSender = from;
+        }
 
-        TaskStoreAsyncParameter(from, &pendingReceive, sizeof(pendingReceive));
+        to->mailboxTail = from;
+        status = STATUS_SUCCESS;
     }
 
     return status;
@@ -129,38 +340,66 @@ IpcReceive
 {
     RT_STATUS status;
 
-    if(!RtCircularBufferIsEmpty(&td->mailbox))
+    if(NULL != td->messageHead)
     {
-        PENDING_MESSAGE pendingMessage;
+        IPC_MESSAGE* ipcMessage = td->messageHead;
+        INT length = min(bufferLength, ipcMessage->length);
 
-        status = RtCircularBufferPeekAndPop(&td->mailbox,
-                                            &pendingMessage,
-                                            sizeof(pendingMessage));
+        td->messageHead = ipcMessage->next;
+        td->messageCount--;
 
-        if(RT_SUCCESS(status))
+        if(NULL == td->messageHead)
         {
-            // Figure out how many bytes we actually want to copy
-            // TODO: We should probably do something if there are excess bytes
-            INT length = min(bufferLength, pendingMessage.messageLength);
+            td->messageTail = NULL;
+        }
 
-            // Perform the copy
-            RtMemcpy(buffer, 
-                     pendingMessage.message,
-                     length);
+        // The sender was counted when it posted the message
+        IpcpCopyMessage(buffer, ipcMessage->data, length);
+        PerformanceGetCounters(td->taskId)->bytesReceived += length;
 
-            // Finish the system call
-            *sendingTaskId = pendingMessage.from->taskId;
-            *bytesReceived = length;
+        *sendingTaskId = ipcMessage->senderId;
+        *bytesReceived = length;
 
-            // Update states
-            pendingMessage.from->state = ReplyBlockedState;
+        IpcpFreeMessage(ipcMessage);
+        status = STATUS_SUCCESS;
+    }
+    else if(NULL != td->mailboxHead)
+    {
+        TASK_DESCRIPTOR* from = td->mailboxHead;
+        PENDING_SEND* pendingSend = TaskGetAsyncParameter(from, sizeof(*pendingSend));
+
+        // Figure out how many bytes we actually want to copy
+        // TODO: We should probably do something if there are excess bytes
+        INT length = min(bufferLength, pendingSend->messageLength);
+
+        td->mailboxHead = from->nextSender;
+
+        if(NULL == td->mailboxHead)
+        {
+            td->mailboxTail = NULL;
         }
+
+        // Perform the copy
+        IpcpCopyMessage(buffer, pendingSend->message, length);
+        PerformanceGetCounters(from->taskId)->bytesSent += length;
+        PerformanceGetCounters(td->taskId)->bytesReceived += length;
+
+        // Finish the system call
+        *sendingTaskId = from->taskId;
+        *bytesReceived = length;
+
+        // Update states
+        from->state = ReplyBlockedState;
+        PerformanceSetTaskState(from->taskId, ReplyBlockedState);
+        status = STATUS_SUCCESS;
     }
     else
     {
-        PENDING_RECEIVE pendingReceive = { sendingTaskId, buffer, bufferLength };
+        PENDING_RECEIVE* pendingReceive = TaskGetAsyncParameter(td, sizeof(*pendingReceive));
 
-        TaskStoreAsyncParameter(td, &pendingReceive, sizeof(pendingReceive));
+        pendingReceive->senderId = sendingTaskId;
+        pendingReceive->buffer = buffer;
+        pendingReceive->bufferLength = bufferLength;
 
         status = STATUS_SUCCESS;
         td->state = SendBlockedState;
@@ -181,23 +420,25 @@ IpcReply
 {
     RT_STATUS status;
 
-    if(to->state == ReplyBlockedState)
+    // Only the task the sender is waiting on may reply to it
+    if(to->state == ReplyBlockedState && to->server == from)
     {
-        PENDING_RECEIVE pendingReceive;
+        PENDING_SEND* pendingSend = TaskGetAsyncParameter(to, sizeof(*pendingSend));
         INT length;
 
-        TaskRetrieveAsyncParameter(to, &pendingReceive, sizeof(pendingReceive));
-
         // Figure out how many bytes we actually want to copy
         // TODO: We should probably do something if there are excess bytes
-        length = min(messageLength, pendingReceive.bufferLength);
+        length = min(messageLength, pendingSend->replyBufferLength);
 
         // Perform the copy
-        RtMemcpy(pendingReceive.buffer, message, length);
+        IpcpCopyMessage(pendingSend->replyBuffer, message, length);
+        PerformanceGetCounters(from->taskId)->bytesReplied += length;
 
         // Finish the Send() system call
         TaskSetReturnValue(to, length);
 
+        IpcpReleasePriority(to);
+
         // Update states and reschedule the target task
         to->state = ReadyState;
         status = SchedulerAddTask(to);
@@ -209,3 +450,110 @@ IpcReply
 
     return status;
 }
+
+RT_STATUS
+IpcCreateMessage
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN INT receiverId,
+        IN PVOID message,
+        IN INT messageLength,
+        OUT IPC_MESSAGE** ipcMessage
+    )
+{
+    IPC_MESSAGE* newMessage = g_freeMessages;
+
+    if(messageLength < 0 || messageLength > IPC_MAX_MESSAGE_LENGTH)
+    {
+        return STATUS_BUFFER_OVERFLOW;
+    }
+
+    if(NULL == newMessage)
+    {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    g_freeMessages = newMessage->next;
+
+    // The sender is free to reuse its buffer as soon as this returns
+    IpcpCopyMessage(newMessage->data, message, messageLength);
+    PerformanceGetCounters(from->taskId)->bytesSent += messageLength;
+
+    newMessage->next = NULL;
+    newMessage->senderId = from->taskId;
+    newMessage->receiverId = receiverId;
+    newMessage->length = messageLength;
+
+    *ipcMessage = newMessage;
+
+    return STATUS_SUCCESS;
+}
+
+RT_STATUS
+IpcPostMessage
+    (
+        IN IPC_MESSAGE* ipcMessage
+    )
+{
+    TASK_DESCRIPTOR* to;
+    RT_STATUS status = TaskDescriptorGet(ipcMessage->receiverId, &to);
+
+    if(RT_SUCCESS(status) && ZombieState == to->state)
+    {
+        status = STATUS_NOT_FOUND;
+    }
+
+    if(RT_FAILURE(status))
+    {
+        IpcpFreeMessage(ipcMessage);
+    }
+    else if(to->state == SendBlockedState)
+    {
+        PENDING_RECEIVE* pendingReceive = TaskGetAsyncParameter(to, sizeof(*pendingReceive));
+        INT length = min(ipcMessage->length, pendingReceive->bufferLength);
+
+        IpcpCopyMessage(pendingReceive->buffer, ipcMessage->data, length);
+        PerformanceGetCounters(to->taskId)->bytesReceived += length;
+
+        // Finish the Receive() system call
+        *(pendingReceive->senderId) = ipcMessage->senderId;
+        TaskSetReturnValue(to, length);
+
+        if(to->timeoutPending)
+        {
+            ClockCancelTimeout(to);
+        }
+
+        IpcpFreeMessage(ipcMessage);
+
+        to->state = ReadyState;
+        status = SchedulerAddTask(to);
+    }
+    else
+    {
+        ipcMessage->next = NULL;
+
+        if(NULL == to->messageHead)
+        {
+            to->messageHead = ipcMessage;
+        }
+        else
+        {
+            to->messageTail->next = ipcMessage;
+        }
+
+        to->messageTail = ipcMessage;
+        to->messageCount++;
+    }
+
+    return status;
+}
+
+BOOLEAN
+IpcIsMessageQueueFull
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    return td->messageCount >= MAX_POSTED_MESSAGES;
+}
@@ -3,12 +3,41 @@
 #include <rt.h>
 #include "task_descriptor.h"
 
+// Must be a multiple of 4
+#define IPC_MAX_MESSAGE_LENGTH MAX_POSTED_MESSAGE_LENGTH
+#define IPC_NUM_MESSAGES 64
+
+// A message the kernel holds on to for a sender that is not blocked
+typedef struct _IPC_MESSAGE
+{
+    struct _IPC_MESSAGE* next;
+    INT senderId;
+    INT receiverId;
+    UINT deliveryTick;
+    INT length;
+    UINT data[IPC_MAX_MESSAGE_LENGTH / sizeof(UINT)];
+} IPC_MESSAGE;
+
+VOID
+IpcInit
+    (
+        VOID
+    );
+
 VOID
 IpcInitializeMailbox
     (
         IN TASK_DESCRIPTOR* td
     );
 
+// While a task that outranks td is in Send() to it,
+// td runs at that task's priority
+VOID
+IpcEnablePriorityInheritance
+    (
+        IN TASK_DESCRIPTOR* td
+    );
+
 VOID
 IpcDrainMailbox
     (
@@ -44,3 +73,27 @@ IpcReply
         IN PVOID reply,
         IN INT replyLength
     );
+
+RT_STATUS
+IpcCreateMessage
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN INT receiverId,
+        IN PVOID message,
+        IN INT messageLength,
+        OUT IPC_MESSAGE** ipcMessage
+    );
+
+RT_STATUS
+IpcPostMessage
+    (
+        IN IPC_MESSAGE* ipcMessage
+    );
+
+// Post() holds each receiver to MAX_POSTED_MESSAGES waiting.
+// Delayed messages don't count against it.
+BOOLEAN
+IpcIsMessageQueueFull
+    (
+        IN TASK_DESCRIPTOR* td
+    );
@@ -4,11 +4,15 @@
 #include <rtosc/assert.h>
 
 #include "cache.h"
+#include "clock.h"
 #include "interrupt.h"
+#include "ipc.h"
 #include "performance.h"
 #include "scheduler.h"
 #include "syscall.h"
 #include "task.h"
+#include "topic.h"
+#include "trace.h"
 #include "trap.h"
 
 extern
@@ -31,7 +35,10 @@ KernelCreateTask
 
     return TaskCreate(NULL,
                       priority,
+                      LargeStack,
                       startFunc,
+                      NULL,
+                      0,
                       &unused);
 }
 
@@ -44,14 +51,20 @@ KernelpInit
     )
 {
     CacheInit();
+    ClockInit();
     InterruptInit();
+    IpcInit();
     PerformanceInit();
     SchedulerInit();
     SyscallInit();
     TaskInit();
+    TopicInit();
+    TraceInit();
     TrapInstallHandler();
 
-    VERIFY(RT_SUCCESS(KernelCreateTask(LowestSystemPriority, InitOsTasks)));
+    // The init task has to outrank every service it creates.  It exits
+    // once the user init task exists, which is what lowers it.
+    VERIFY(RT_SUCCESS(KernelCreateTask(Priority30, InitOsTasks)));
 }
 
 VOID
@@ -80,10 +93,44 @@ KernelRun
 
             nextTd->state = RunningState;
 
-            // Return to user mode
-            PerformanceEnterTask();
-            KernelLeave(nextTd->stackPointer);
-            PerformanceExitTask(nextTd->taskId);
+            // An interrupt woke this task up.  It is finally running.
+            if(NumEvent != nextTd->wokenEvent)
+            {
+                PerformanceRecordEventLatency(nextTd->wokenEvent, nextTd->wokenTicks);
+                nextTd->wokenEvent = NumEvent;
+            }
+
+            TraceRecord(TraceContextSwitch, nextTd->taskId, nextTd->priority);
+            PerformanceEnterTask(nextTd);
+
+            while(1)
+            {
+                // Return to user mode
+                g_lastSystemCall = NumSystemCall;
+                KernelLeave(nextTd->stackPointer);
+                PerformanceExitTask(nextTd->taskId, g_lastSystemCall);
+
+                if(g_lastSystemCall < NumSystemCall)
+                {
+                    TraceRecordAt(TraceSystemCallEnter, nextTd->taskId, g_lastSystemCall, g_lastSystemCallTicks);
+                    TraceRecord(TraceSystemCallExit, nextTd->taskId, g_lastSystemCall);
+                }
+
+                // The scheduler would pick the task again if it is still
+                // running and nothing at its priority or higher is ready.
+                // Resume it without going through the ready queues.
+                if(RunningState != nextTd->state || !SchedulerIsCurrentTaskNext())
+                {
+                    break;
+                }
+
+                if(g_lastSystemCall >= NumSystemCall)
+                {
+                    TraceRecord(TraceContextSwitch, nextTd->taskId, nextTd->priority);
+                }
+
+                PerformanceResumeTask();
+            }
 
             // The task may have transitioned to a new state
             // due to interrupts, Exit(), etc.  Don't update
@@ -92,6 +139,11 @@ KernelRun
             {
                 nextTd->state = ReadyState;
             }
+            else if(nextTd->state != ReadyState && nextTd->state != ZombieState)
+            {
+                // Start timing how long the task stays blocked
+                PerformanceSetTaskState(nextTd->taskId, nextTd->state);
+            }
         }
         else if(STATUS_NOT_FOUND == status)
         {
@@ -107,4 +159,9 @@ KernelRun
     // Be a good citizen and disable all interrupts so that we don't
     // mess with any other group's kernel
     InterruptDisableAll();
+
+    PerformancePrintEventLatencies();
+    PerformancePrintInversions();
+    PerformancePrintSystemCalls();
+    TraceShutdown();
 }
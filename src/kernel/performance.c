@@ -1,13 +1,42 @@
 #include "performance.h"
 
+#include <bwio/bwio.h>
 #include <rtos.h>
+#include <rtosc/string.h>
 #include <ts7200.h>
 
-#include "task_descriptor.h"
-
-static TASK_PERFORMANCE g_taskPerformanceCounters[NUM_TASKS];
+TASK_PERFORMANCE g_taskPerformanceCounters[NUM_TASKS];
 static UINT g_lastTick;
 
+// Timer3 runs at 508 khz
+#define PERFORMANCE_TICKS_TO_US(ticks) (((ticks) * 1967) / 1000)
+
+static EVENT_LATENCY g_eventLatencies[NumEvent];
+
+// The state each task was last put in, and when
+static TASK_STATE g_taskStates[NUM_TASKS];
+static UINT g_taskStateTicks[NUM_TASKS];
+
+// Utilization is sampled every 10 clock ticks.  Each sample carries 1/8 of
+// the weight of the moving average, and the windows are 10 and 100 samples.
+#define PERFORMANCE_SAMPLE_CLOCK_TICKS 10
+#define PERFORMANCE_AVERAGE_SHIFT 3
+#define PERFORMANCE_SHORT_WINDOW_SAMPLES 10
+#define PERFORMANCE_LONG_WINDOW_SAMPLES 100
+
+typedef struct _PERFORMANCE_WINDOW
+{
+    UINT elapsedTicks;
+    UINT activeTicks[NUM_TASKS];
+} PERFORMANCE_WINDOW;
+
+static UINT g_sampleTimer3;
+static UINT g_sampleActiveTicks[NUM_TASKS];
+static UINT g_clockTicksUntilSample;
+static UINT g_samples;
+static PERFORMANCE_WINDOW g_shortWindow;
+static PERFORMANCE_WINDOW g_longWindow;
+
 static
 inline
 VOID
@@ -33,24 +62,94 @@ PerformancepGetTimer3
     return *(UINT*)(TIMER3_BASE + VAL_OFFSET);
 }
 
+static
+inline
+VOID
+PerformancepAddBlockedTicks
+    (
+        IN TASK_PERFORMANCE* counters,
+        IN TASK_STATE state,
+        IN UINT elapsed
+    )
+{
+    switch(state)
+    {
+        case SendBlockedState:
+            counters->sendBlockedTicks += elapsed;
+            break;
+
+        case ReceiveBlockedState:
+            counters->receiveBlockedTicks += elapsed;
+            break;
+
+        case ReplyBlockedState:
+            counters->replyBlockedTicks += elapsed;
+            break;
+
+        case EventBlockedState:
+            counters->eventBlockedTicks += elapsed;
+            break;
+
+        case SubscribeBlockedState:
+            counters->subscribeBlockedTicks += elapsed;
+            break;
+
+        default:
+            break;
+    }
+}
+
 VOID
 PerformanceInit
     (
         VOID
     )
 {
+    UINT i;
+
     PerformancepSetupTimer3();
 
-    UINT i;
-    for (i = 0; i < NUM_TASKS; i++)
+    RtMemset(g_taskPerformanceCounters, sizeof(g_taskPerformanceCounters), 0);
+
+    // No slot has an owner until PerformanceResetTask() gives it one
+    for(i = 0; i < NUM_TASKS; i++)
     {
-        g_taskPerformanceCounters[i].activeTicks = 0;
+        g_taskPerformanceCounters[i].taskId = -1;
     }
 
+    RtMemset(g_taskStates, sizeof(g_taskStates), 0);
+    RtMemset(g_taskStateTicks, sizeof(g_taskStateTicks), 0);
+    RtMemset(g_eventLatencies, sizeof(g_eventLatencies), 0);
+    RtMemset(g_sampleActiveTicks, sizeof(g_sampleActiveTicks), 0);
+    RtMemset(&g_shortWindow, sizeof(g_shortWindow), 0);
+    RtMemset(&g_longWindow, sizeof(g_longWindow), 0);
+
     g_lastTick = 0;
+    g_sampleTimer3 = PerformancepGetTimer3();
+    g_clockTicksUntilSample = PERFORMANCE_SAMPLE_CLOCK_TICKS;
+    g_samples = 0;
 }
 
 
+VOID
+PerformanceResetTask
+    (
+        IN INT taskId
+    )
+{
+    UINT taskIndex = taskId % NUM_TASKS;
+
+    // The slot may have belonged to a task that has since exited
+    RtMemset(&g_taskPerformanceCounters[taskIndex], sizeof(g_taskPerformanceCounters[taskIndex]), 0);
+    g_taskPerformanceCounters[taskIndex].taskId = taskId;
+
+    g_taskStates[taskIndex] = ReadyState;
+    g_taskStateTicks[taskIndex] = PerformancepGetTimer3();
+    g_sampleActiveTicks[taskIndex] = 0;
+    g_shortWindow.activeTicks[taskIndex] = 0;
+    g_longWindow.activeTicks[taskIndex] = 0;
+}
+
 RT_STATUS
 PerformanceGet
     (
@@ -58,9 +157,19 @@ PerformanceGet
         OUT TASK_PERFORMANCE* performance
     )
 {
-    if (0 <= taskId && taskId < NUM_TASKS)
+    UINT taskIndex = taskId % NUM_TASKS;
+
+    // The slot has to still hold this task's counters, not a later owner's
+    if (0 <= taskId && taskId == g_taskPerformanceCounters[taskIndex].taskId)
     {
-        *performance = g_taskPerformanceCounters[taskId];
+        *performance = g_taskPerformanceCounters[taskIndex];
+
+        // Include the time the task has been blocked so far.
+        // Timer3 counts down, and unsigned math takes care of wrap around.
+        PerformancepAddBlockedTicks(performance,
+                                    g_taskStates[taskIndex],
+                                    g_taskStateTicks[taskIndex] - PerformancepGetTimer3());
+
         return STATUS_SUCCESS;
     }
     return STATUS_FAILURE;
@@ -68,6 +177,30 @@ PerformanceGet
 
 VOID
 PerformanceEnterTask
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    UINT taskIndex = td->taskId % NUM_TASKS;
+    TASK_PERFORMANCE* counters = &g_taskPerformanceCounters[taskIndex];
+    UINT now = PerformancepGetTimer3();
+
+    counters->contextSwitches++;
+
+    // The task sat in a ready queue while a task that outranks it was in
+    // Send() to it.  Priority inheritance is what keeps this time short.
+    if(ReadyState == g_taskStates[taskIndex] && td->clientPriorities > td->basePriority)
+    {
+        counters->inversionTicks += g_taskStateTicks[taskIndex] - now;
+    }
+
+    g_taskStates[taskIndex] = RunningState;
+    g_taskStateTicks[taskIndex] = now;
+    g_lastTick = now;
+}
+
+VOID
+PerformanceResumeTask
     (
         VOID
     )
@@ -78,10 +211,23 @@ PerformanceEnterTask
 VOID
 PerformanceExitTask
     (
-        IN INT taskId
+        IN INT taskId,
+        IN UINT systemCall
     )
 {
     UINT timer3Value = PerformancepGetTimer3();
+
+    taskId = taskId % NUM_TASKS;
+
+    if(systemCall < NumSystemCall)
+    {
+        g_taskPerformanceCounters[taskId].systemCalls[systemCall]++;
+    }
+    else
+    {
+        g_taskPerformanceCounters[taskId].preemptions++;
+    }
+
     if (timer3Value >= g_lastTick)
     {
         g_taskPerformanceCounters[taskId].activeTicks += (timer3Value - g_lastTick);
@@ -91,3 +237,300 @@ PerformanceExitTask
         g_taskPerformanceCounters[taskId].activeTicks += (g_lastTick + (UINT_MAX - timer3Value));
     }
 }
+
+VOID
+PerformanceSetTaskState
+    (
+        IN INT taskId,
+        IN TASK_STATE state
+    )
+{
+    UINT now = PerformancepGetTimer3();
+
+    taskId = taskId % NUM_TASKS;
+
+    PerformancepAddBlockedTicks(&g_taskPerformanceCounters[taskId],
+                                g_taskStates[taskId],
+                                g_taskStateTicks[taskId] - now);
+
+    g_taskStates[taskId] = state;
+    g_taskStateTicks[taskId] = now;
+}
+
+static
+inline
+UINT
+PerformancepUtilization
+    (
+        IN UINT activeTicks,
+        IN UINT elapsedTicks
+    )
+{
+    if(0 == activeTicks || 0 == elapsedTicks)
+    {
+        return 0;
+    }
+
+    // Stay in 32 bits.  Dropping precision from both sides keeps the ratio.
+    while(activeTicks > UINT_MAX / FULL_UTILIZATION)
+    {
+        activeTicks >>= 1;
+        elapsedTicks >>= 1;
+    }
+
+    return min((activeTicks * FULL_UTILIZATION) / max(elapsedTicks, 1), FULL_UTILIZATION);
+}
+
+static
+inline
+VOID
+PerformancepCloseWindow
+    (
+        IN PERFORMANCE_WINDOW* window,
+        IN UINT taskIndex,
+        OUT UINT* utilization
+    )
+{
+    *utilization = PerformancepUtilization(window->activeTicks[taskIndex], window->elapsedTicks);
+    window->activeTicks[taskIndex] = 0;
+}
+
+VOID
+PerformanceTick
+    (
+        VOID
+    )
+{
+    UINT now;
+    UINT elapsed;
+    BOOLEAN closeShortWindow;
+    BOOLEAN closeLongWindow;
+    UINT i;
+
+    if(--g_clockTicksUntilSample > 0)
+    {
+        return;
+    }
+
+    // Timer3 counts down, and unsigned math takes care of wrap around
+    now = PerformancepGetTimer3();
+    elapsed = g_sampleTimer3 - now;
+
+    g_sampleTimer3 = now;
+    g_clockTicksUntilSample = PERFORMANCE_SAMPLE_CLOCK_TICKS;
+    g_samples++;
+
+    g_shortWindow.elapsedTicks += elapsed;
+    g_longWindow.elapsedTicks += elapsed;
+
+    closeShortWindow = 0 == g_samples % PERFORMANCE_SHORT_WINDOW_SAMPLES;
+    closeLongWindow = 0 == g_samples % PERFORMANCE_LONG_WINDOW_SAMPLES;
+
+    for(i = 0; i < NUM_TASKS; i++)
+    {
+        TASK_PERFORMANCE* counters = &g_taskPerformanceCounters[i];
+        UINT active = counters->activeTicks - g_sampleActiveTicks[i];
+        UINT sample = PerformancepUtilization(active, elapsed);
+
+        g_sampleActiveTicks[i] = counters->activeTicks;
+
+        counters->utilization = counters->utilization
+                                - (counters->utilization >> PERFORMANCE_AVERAGE_SHIFT)
+                                + (sample >> PERFORMANCE_AVERAGE_SHIFT);
+
+        g_shortWindow.activeTicks[i] += active;
+        g_longWindow.activeTicks[i] += active;
+
+        if(closeShortWindow)
+        {
+            PerformancepCloseWindow(&g_shortWindow, i, &counters->utilization1s);
+        }
+
+        if(closeLongWindow)
+        {
+            PerformancepCloseWindow(&g_longWindow, i, &counters->utilization10s);
+        }
+    }
+
+    if(closeShortWindow)
+    {
+        g_shortWindow.elapsedTicks = 0;
+    }
+
+    if(closeLongWindow)
+    {
+        g_longWindow.elapsedTicks = 0;
+    }
+}
+
+VOID
+PerformanceRecordEventLatency
+    (
+        IN EVENT event,
+        IN UINT interruptTicks
+    )
+{
+    EVENT_LATENCY* latency = &g_eventLatencies[event];
+    UINT ticks = interruptTicks - PerformancepGetTimer3();
+    UINT bucket = 0;
+    UINT remaining = ticks >> 1;
+
+    // No clz on the ARM920T, but there are only a few buckets to walk
+    while(remaining && bucket < NUM_LATENCY_BUCKETS - 1)
+    {
+        remaining >>= 1;
+        bucket++;
+    }
+
+    latency->count++;
+    latency->totalTicks += ticks;
+    latency->maxTicks = max(latency->maxTicks, ticks);
+    latency->buckets[bucket]++;
+}
+
+RT_STATUS
+PerformanceGetEventLatency
+    (
+        IN EVENT event,
+        OUT EVENT_LATENCY* latency
+    )
+{
+    if(ClockEvent <= event && event < NumEvent)
+    {
+        *latency = g_eventLatencies[event];
+        return STATUS_SUCCESS;
+    }
+
+    return STATUS_FAILURE;
+}
+
+VOID
+PerformancePrintEventLatencies
+    (
+        VOID
+    )
+{
+    static const STRING eventNames[NumEvent] = { "Clock",
+                                                 "COM1 receive",
+                                                 "COM1 transmit",
+                                                 "COM2 receive",
+                                                 "COM2 transmit" };
+    UINT event;
+
+    bwprintf(BWCOM2, "\r\nInterrupt to handler latency (us)\r\n");
+
+    for(event = 0; event < NumEvent; event++)
+    {
+        EVENT_LATENCY* latency = &g_eventLatencies[event];
+        UINT i;
+
+        if(0 == latency->count)
+        {
+            continue;
+        }
+
+        bwprintf(BWCOM2,
+                 "%s: %d events, mean %d, max %d\r\n",
+                 eventNames[event],
+                 latency->count,
+                 PERFORMANCE_TICKS_TO_US(latency->totalTicks / latency->count),
+                 PERFORMANCE_TICKS_TO_US(latency->maxTicks));
+
+        for(i = 0; i < NUM_LATENCY_BUCKETS; i++)
+        {
+            if(latency->buckets[i])
+            {
+                bwprintf(BWCOM2,
+                         "    < %d: %d\r\n",
+                         PERFORMANCE_TICKS_TO_US(2 << i),
+                         latency->buckets[i]);
+            }
+        }
+    }
+}
+
+VOID
+PerformancePrintInversions
+    (
+        VOID
+    )
+{
+    UINT i;
+
+    bwprintf(BWCOM2, "\r\nReady while an outranking task waited (us)\r\n");
+
+    for(i = 0; i < NUM_TASKS; i++)
+    {
+        TASK_PERFORMANCE* counters = &g_taskPerformanceCounters[i];
+
+        if(counters->inversionTicks)
+        {
+            bwprintf(BWCOM2,
+                     "Task %d: %d\r\n",
+                     i,
+                     PERFORMANCE_TICKS_TO_US(counters->inversionTicks));
+        }
+    }
+}
+
+// Must match SYSTEM_CALL_NUMBER in inc/rtos/rtkernel.h
+static const STRING g_systemCallNames[] = { "Create",
+                                            "MyTid",
+                                            "MyParentTid",
+                                            "Pass",
+                                            "Exit",
+                                            "Send",
+                                            "Receive",
+                                            "Reply",
+                                            "AwaitEvent",
+                                            "QueryPerformance",
+                                            "CreateEx",
+                                            "DumpKernelTrace",
+                                            "QueryEventLatency",
+                                            "DelayedSend",
+                                            "SendAt",
+                                            "ReceiveTimeout",
+                                            "Post",
+                                            "CreateTopic",
+                                            "Subscribe",
+                                            "Publish",
+                                            "AwaitEventData",
+                                            "QueryPerformanceAll",
+                                            "EnablePriorityInheritance",
+                                            "CreateWithArg",
+                                            "CreateExWithArg",
+                                            "ReadKernelTrace",
+                                            "ReceiveUntil" };
+
+compile_assert(SystemCallNamesMatch, sizeof(g_systemCallNames) / sizeof(g_systemCallNames[0]) == NumSystemCall);
+
+VOID
+PerformancePrintSystemCalls
+    (
+        VOID
+    )
+{
+    UINT total = 0;
+    UINT systemCall;
+
+    bwprintf(BWCOM2, "\r\nSystem calls made by every task\r\n");
+
+    for(systemCall = 0; systemCall < NumSystemCall; systemCall++)
+    {
+        UINT count = 0;
+        UINT i;
+
+        for(i = 0; i < NUM_TASKS; i++)
+        {
+            count += g_taskPerformanceCounters[i].systemCalls[systemCall];
+        }
+
+        if(count)
+        {
+            bwprintf(BWCOM2, "%s: %d\r\n", g_systemCallNames[systemCall], count);
+            total += count;
+        }
+    }
+
+    bwprintf(BWCOM2, "Total: %d\r\n", total);
+}
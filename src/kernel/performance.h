@@ -2,6 +2,20 @@
 
 #include <rt.h>
 #include <rtkernel.h>
+#include "task_descriptor.h"
+
+extern TASK_PERFORMANCE g_taskPerformanceCounters[NUM_TASKS];
+
+static
+inline
+TASK_PERFORMANCE*
+PerformanceGetCounters
+    (
+        IN INT taskId
+    )
+{
+    return &g_taskPerformanceCounters[taskId % NUM_TASKS];
+}
 
 VOID
 PerformanceInit
@@ -9,6 +23,13 @@ PerformanceInit
         VOID
     );
 
+// Clears the counters a new task inherits from its slot's last owner
+VOID
+PerformanceResetTask
+    (
+        IN INT taskId
+    );
+
 RT_STATUS
 PerformanceGet
     (
@@ -18,6 +39,14 @@ PerformanceGet
 
 VOID
 PerformanceEnterTask
+    (
+        IN TASK_DESCRIPTOR* td
+    );
+
+// The task that just left the kernel is running again without
+// having been switched out
+VOID
+PerformanceResumeTask
     (
         VOID
     );
@@ -25,5 +54,54 @@ PerformanceEnterTask
 VOID
 PerformanceExitTask
     (
-        IN INT taskId
+        IN INT taskId,
+        IN UINT systemCall
+    );
+
+VOID
+PerformanceSetTaskState
+    (
+        IN INT taskId,
+        IN TASK_STATE state
+    );
+
+// Called on every clock tick to sample utilization
+VOID
+PerformanceTick
+    (
+        VOID
+    );
+
+VOID
+PerformanceRecordEventLatency
+    (
+        IN EVENT event,
+        IN UINT interruptTicks
+    );
+
+RT_STATUS
+PerformanceGetEventLatency
+    (
+        IN EVENT event,
+        OUT EVENT_LATENCY* latency
+    );
+
+VOID
+PerformancePrintEventLatencies
+    (
+        VOID
+    );
+
+// Prints how long each server kept a higher priority task waiting
+VOID
+PerformancePrintInversions
+    (
+        VOID
+    );
+
+// Prints how many of each system call reached the kernel
+VOID
+PerformancePrintSystemCalls
+    (
+        VOID
     );
@@ -1,12 +1,108 @@
 #include "scheduler.h"
 
-#include <rtosc/priority_queue.h>
+#include <rtosc/assert.h>
+#include "performance.h"
+
+typedef struct _READY_QUEUE
+{
+    TASK_DESCRIPTOR* head;
+    TASK_DESCRIPTOR* tail;
+} READY_QUEUE;
 
 TASK_DESCRIPTOR* g_currentTd;
 
-static TASK_DESCRIPTOR* g_taskDescriptorsPriorityQueueData[NumPriority][NUM_TASKS];
-static RT_CIRCULAR_BUFFER g_taskDescriptorPriorityQueueBuffer[NumPriority];
-static RT_PRIORITY_QUEUE g_taskDescriptorPriorityQueue;
+static READY_QUEUE g_readyQueues[NumPriority];
+
+// Priorities are single bits, so a priority's bit is set here
+// whenever its ready queue is not empty
+UINT g_readyPriorities;
+
+static
+inline
+VOID
+SchedulerpPush
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    READY_QUEUE* queue = &g_readyQueues[SchedulerPriorityIndex(td->priority)];
+
+    td->nextReady = NULL;
+
+    if(NULL == queue->head)
+    {
+        queue->head = td;
+        g_readyPriorities |= td->priority;
+    }
+    else
+    {
+        queue->tail->nextReady = td;
+    }
+
+    queue->tail = td;
+}
+
+static
+inline
+TASK_DESCRIPTOR*
+SchedulerpPopHighest
+    (
+        VOID
+    )
+{
+    UINT priority = SchedulerHighestPriority(g_readyPriorities);
+    READY_QUEUE* queue = &g_readyQueues[SchedulerPriorityIndex(priority)];
+    TASK_DESCRIPTOR* td = queue->head;
+
+    queue->head = td->nextReady;
+
+    if(NULL == queue->head)
+    {
+        queue->tail = NULL;
+        g_readyPriorities &= ~priority;
+    }
+
+    return td;
+}
+
+static
+inline
+VOID
+SchedulerpRemove
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    READY_QUEUE* queue = &g_readyQueues[SchedulerPriorityIndex(td->priority)];
+    TASK_DESCRIPTOR* previous = NULL;
+    TASK_DESCRIPTOR* current = queue->head;
+
+    // Ready queues are short, so walking one is cheap
+    while(current != td)
+    {
+        previous = current;
+        current = current->nextReady;
+    }
+
+    if(NULL == previous)
+    {
+        queue->head = td->nextReady;
+    }
+    else
+    {
+        previous->nextReady = td->nextReady;
+    }
+
+    if(queue->tail == td)
+    {
+        queue->tail = previous;
+    }
+
+    if(NULL == queue->head)
+    {
+        g_readyPriorities &= ~td->priority;
+    }
+}
 
 VOID
 SchedulerInit
@@ -14,14 +110,16 @@ SchedulerInit
         VOID
     )
 {
+    UINT i;
+
     g_currentTd = NULL;
+    g_readyPriorities = 0;
 
-    RtPriorityQueueInit(&g_taskDescriptorPriorityQueue,
-                        g_taskDescriptorsPriorityQueueData,
-                        g_taskDescriptorPriorityQueueBuffer,
-                        sizeof(TASK_DESCRIPTOR*),
-                        NumPriority,
-                        NUM_TASKS);
+    for(i = 0; i < NumPriority; i++)
+    {
+        g_readyQueues[i].head = NULL;
+        g_readyQueues[i].tail = NULL;
+    }
 }
 
 RT_STATUS
@@ -30,7 +128,34 @@ SchedulerAddTask
         IN TASK_DESCRIPTOR* td
     )
 {
-    return RtPriorityQueuePush(&g_taskDescriptorPriorityQueue, td->priority, &td, sizeof(td));
+    // TaskCreate only hands out powers of 2
+    ASSERT(td->priority && !(td->priority & (td->priority - 1)));
+
+    // Tasks only get added once they are unblocked
+    PerformanceSetTaskState(td->taskId, ReadyState);
+    SchedulerpPush(td);
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+SchedulerSetPriority
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN TASK_PRIORITY priority
+    )
+{
+    // The current task is never in a ready queue
+    if(ReadyState == td->state && td != g_currentTd)
+    {
+        SchedulerpRemove(td);
+        td->priority = priority;
+        SchedulerpPush(td);
+    }
+    else
+    {
+        td->priority = priority;
+    }
 }
 
 RT_STATUS
@@ -39,40 +164,28 @@ SchedulerGetNextTask
         OUT TASK_DESCRIPTOR** td
     )
 {
-    TASK_DESCRIPTOR* nextTd;
-
-    RT_STATUS status = RtPriorityQueuePeek(&g_taskDescriptorPriorityQueue, &nextTd, sizeof(nextTd));
+    RT_STATUS status = STATUS_SUCCESS;
 
     if(NULL != g_currentTd && ReadyState == g_currentTd->state)
     {
-        if(RT_SUCCESS(status) && nextTd->priority >= g_currentTd->priority)
-        {
-            status = RtPriorityQueuePop(&g_taskDescriptorPriorityQueue, sizeof(nextTd));
-
-            if(RT_SUCCESS(status))
-            {
-                status = SchedulerAddTask(g_currentTd);
-
-                if(RT_SUCCESS(status))
-                {
-                    g_currentTd = nextTd;
-                }
-            }
-        }
-        else
+        // With one bit per priority, any ready task at the same or a
+        // higher priority makes the bitmap at least as large
+        if(g_readyPriorities >= g_currentTd->priority)
         {
-            // Reschedule the current task
-            status = STATUS_SUCCESS;
+            PerformanceSetTaskState(g_currentTd->taskId, ReadyState);
+            SchedulerpPush(g_currentTd);
+            g_currentTd = SchedulerpPopHighest();
         }
+
+        // Otherwise reschedule the current task
     }
-    else if(RT_SUCCESS(status))
+    else if(0 != g_readyPriorities)
     {
-        status = RtPriorityQueuePop(&g_taskDescriptorPriorityQueue, sizeof(nextTd));
-
-        if(RT_SUCCESS(status))
-        {
-            g_currentTd = nextTd;
-        }
+        g_currentTd = SchedulerpPopHighest();
+    }
+    else
+    {
+        status = STATUS_NOT_FOUND;
     }
 
     *td = g_currentTd;
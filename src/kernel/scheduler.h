@@ -3,6 +3,47 @@
 #include <rt.h>
 #include "task.h"
 
+// Priorities are single bits.  Returns which bit priority is.
+static
+inline
+UINT
+SchedulerPriorityIndex
+    (
+        IN UINT priority
+    )
+{
+    // The ARM920T has no clz instruction.  This code is taken from:
+    // http://graphics.stanford.edu/~seander/bithacks.html#IntegerLogDeBruijn
+    static const UCHAR MultiplyDeBruijnBitPosition[32] =
+    {
+      0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+      31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+
+    return MultiplyDeBruijnBitPosition[(UINT)(priority * 0x077CB531U) >> 27];
+}
+
+// Returns the highest priority in a set of priority bits
+static
+inline
+UINT
+SchedulerHighestPriority
+    (
+        IN UINT priorities
+    )
+{
+    UINT v = priorities;
+
+    // Smear the top bit down, then keep only the top bit
+    v |= v >> 1;
+    v |= v >> 2;
+    v |= v >> 4;
+    v |= v >> 8;
+    v |= v >> 16;
+
+    return v ^ (v >> 1);
+}
+
 VOID
 SchedulerInit
     (
@@ -15,6 +56,15 @@ SchedulerAddTask
         IN TASK_DESCRIPTOR* td
     );
 
+// Moves a task to another priority.  A task waiting
+// in a ready queue moves to the new priority's queue.
+VOID
+SchedulerSetPriority
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN TASK_PRIORITY priority
+    );
+
 RT_STATUS
 SchedulerGetNextTask
     (
@@ -23,6 +73,22 @@ SchedulerGetNextTask
 
 extern TASK_DESCRIPTOR* g_currentTd;
 
+// One bit for each priority with a task in its ready queue
+extern UINT g_readyPriorities;
+
+// Whether SchedulerGetNextTask() would keep the current task running.
+// Nothing at its priority or higher is waiting for the processor.
+static
+inline
+BOOLEAN
+SchedulerIsCurrentTaskNext
+    (
+        VOID
+    )
+{
+    return g_readyPriorities < g_currentTd->priority;
+}
+
 static
 inline
 TASK_DESCRIPTOR*
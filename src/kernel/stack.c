@@ -1,25 +1,43 @@
 #include "stack.h"
 
 #include <rtosc/buffer.h>
-#include <rtkernel.h>
 
-#define STACK_SIZE  0x10000
+#define SMALL_STACK_SIZE    0x1000
+#define MEDIUM_STACK_SIZE   0x4000
+#define LARGE_STACK_SIZE    0x10000
+
+// Most tasks are notifiers.  Only servers
+// with big local arrays need large stacks.
+#define NUM_SMALL_STACKS    NUM_TASKS
+#define NUM_MEDIUM_STACKS   NUM_TASKS
+#define NUM_LARGE_STACKS    (NUM_TASKS / 2)
+#define NUM_STACKS          (NUM_SMALL_STACKS + NUM_MEDIUM_STACKS + NUM_LARGE_STACKS)
+
+#if NLOCAL
+#define STACK_OVERHEAD      0
 #define STACK_ADDRESS_START 0x00400000
 #define STACK_ADDRESS_END   0x01F00000
+#else
+// Host tasks also take signal frames and a TRAP_FRAME on their stacks
+#define STACK_OVERHEAD      0x8000
+#define STACK_MEMORY_SIZE   (NUM_SMALL_STACKS * (SMALL_STACK_SIZE + STACK_OVERHEAD) + \
+                             NUM_MEDIUM_STACKS * (MEDIUM_STACK_SIZE + STACK_OVERHEAD) + \
+                             NUM_LARGE_STACKS * (LARGE_STACK_SIZE + STACK_OVERHEAD))
+static UINT g_stackMemory[STACK_MEMORY_SIZE / sizeof(UINT)];
+#define STACK_ADDRESS_START ((UINTPTR) g_stackMemory)
+#define STACK_ADDRESS_END   (STACK_ADDRESS_START + sizeof(g_stackMemory))
+#endif
 
-static STACK g_stacks[NUM_TASKS];
-static STACK* g_availableStacksBuffer[NUM_TASKS];
-static RT_CIRCULAR_BUFFER g_availableStacksQueue;
+static const UINT g_stackSizes[NumStackClass] = { SMALL_STACK_SIZE + STACK_OVERHEAD,
+                                                  MEDIUM_STACK_SIZE + STACK_OVERHEAD,
+                                                  LARGE_STACK_SIZE + STACK_OVERHEAD };
+static const UINT g_numStacks[NumStackClass] = { NUM_SMALL_STACKS,
+                                                 NUM_MEDIUM_STACKS,
+                                                 NUM_LARGE_STACKS };
 
-static
-UINT*
-StackpCalculateAddress
-    (
-        IN UINT stackId
-    )
-{
-    return (UINT*) (STACK_ADDRESS_START + (STACK_SIZE * stackId));
-}
+static STACK g_stacks[NUM_STACKS];
+static STACK* g_availableStacksBuffer[NUM_STACKS];
+static RT_CIRCULAR_BUFFER g_availableStacksQueues[NumStackClass];
 
 RT_STATUS
 StackInit
@@ -27,25 +45,37 @@ StackInit
         VOID
     )
 {
-    UINT i;
+    UINTPTR address = STACK_ADDRESS_START;
+    STACK* stack = g_stacks;
+    STACK** availableStacks = g_availableStacksBuffer;
     RT_STATUS status = STATUS_SUCCESS;
+    UINT stackClass;
 
-    RtCircularBufferInit(&g_availableStacksQueue,
-                         g_availableStacksBuffer,
-                         sizeof(g_availableStacksBuffer));
-
-    for(i = 0; i < NUM_TASKS && RT_SUCCESS(status); i++)
+    // Each class gets its own contiguous run of stacks and its own free list
+    for(stackClass = 0; stackClass < NumStackClass && RT_SUCCESS(status); stackClass++)
     {
-        STACK* stack = &g_stacks[i];
-        stack->top = StackpCalculateAddress(i);
-        stack->size = STACK_SIZE;
+        UINT i;
+
+        RtCircularBufferInit(&g_availableStacksQueues[stackClass],
+                             availableStacks,
+                             g_numStacks[stackClass] * sizeof(STACK*));
+        availableStacks += g_numStacks[stackClass];
 
-        if (stack->top > (UINT*) STACK_ADDRESS_END)
+        for(i = 0; i < g_numStacks[stackClass] && RT_SUCCESS(status); i++)
         {
-            return STATUS_STACK_SPACE_OVERFLOW;
-        }
+            stack->top = (UINT*) address;
+            stack->size = g_stackSizes[stackClass];
+            stack->stackClass = stackClass;
+            address += stack->size;
 
-        status = StackDeallocate(stack);
+            if (address > STACK_ADDRESS_END)
+            {
+                return STATUS_STACK_SPACE_OVERFLOW;
+            }
+
+            status = StackDeallocate(stack);
+            stack++;
+        }
     }
 
     return status;
@@ -54,10 +84,11 @@ StackInit
 RT_STATUS
 StackAllocate
     (
+        IN STACK_CLASS stackClass,
         OUT STACK** stack
     )
 {
-    return RtCircularBufferPeekAndPop(&g_availableStacksQueue,
+    return RtCircularBufferPeekAndPop(&g_availableStacksQueues[stackClass],
                                       stack,
                                       sizeof(*stack));
 }
@@ -68,5 +99,5 @@ StackDeallocate
         IN STACK* stack
     )
 {
-    return RtCircularBufferPush(&g_availableStacksQueue, &stack, sizeof(stack));
+    return RtCircularBufferPush(&g_availableStacksQueues[stack->stackClass], &stack, sizeof(stack));
 }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <rt.h>
+#include <rtkernel.h>
 
 typedef struct _STACK
 {
     UINT* top;
     UINT size;
+    STACK_CLASS stackClass;
 } STACK;
 
 RT_STATUS
@@ -17,6 +19,7 @@ StackInit
 RT_STATUS
 StackAllocate
     (
+        IN STACK_CLASS stackClass,
         OUT STACK** stack
     );
 
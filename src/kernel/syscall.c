@@ -1,37 +1,62 @@
 #include "syscall.h"
 
 #include <rtosc/assert.h>
+#include "clock.h"
 #include "interrupt.h"
 #include "ipc.h"
 #include "performance.h"
 #include "scheduler.h"
 #include "task.h"
+#include "topic.h"
+#include "trace.h"
 
 #define ERROR_SUCCESS 0
 #define ERROR_PRIORITY_INVALID -1
 #define ERROR_OUT_OF_SPACE -2
+#define ERROR_STACK_CLASS_INVALID -3
+#define ERROR_ARGUMENT_INVALID -4
 #define ERROR_INVALID_TASK -1
 #define ERROR_DEAD_TASK -2
 #define ERROR_TASK_NOT_REPLY_BLOCKED -3
 #define ERROR_INVALID_EVENT -1
+#define ERROR_INVALID_PARAMETER -1
+#define ERROR_MESSAGE_TOO_LONG -3
+#define ERROR_TOO_MANY_MESSAGES POST_OUT_OF_MESSAGES
+#define ERROR_QUEUE_FULL POST_QUEUE_FULL
+#define ERROR_INVALID_TOPIC -1
+#define ERROR_OUT_OF_TOPICS -1
 
-#define NUM_SYSCALLS 10
-
-UINT g_systemCallTable[NUM_SYSCALLS];
+PVOID g_systemCallTable[NumSystemCall];
+UINT g_lastSystemCall;
+UINT g_lastSystemCallTicks;
 
 static
+inline
 INT
-SystemCreateTask
+SystempCreateTask
     (
         IN TASK_PRIORITY priority,
-        IN TASK_START_FUNC startFunc
+        IN STACK_CLASS stackClass,
+        IN TASK_START_FUNC startFunc,
+        IN PVOID argument,
+        IN UINT argumentLength
     )
 {
     TASK_DESCRIPTOR* td;
-    RT_STATUS status = TaskCreate(SchedulerGetCurrentTask(),
-                                  priority,
-                                  startFunc,
-                                  &td);
+    RT_STATUS status;
+
+    if((UINT) stackClass >= NumStackClass)
+    {
+        return ERROR_STACK_CLASS_INVALID;
+    }
+
+    status = TaskCreate(SchedulerGetCurrentTask(),
+                        priority,
+                        stackClass,
+                        startFunc,
+                        argument,
+                        argumentLength,
+                        &td);
 
     switch(status)
     {
@@ -50,6 +75,61 @@ SystemCreateTask
     }
 }
 
+static
+INT
+SystemCreateTaskWithStack
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_FUNC startFunc
+    )
+{
+    return SystempCreateTask(priority, stackClass, startFunc, NULL, 0);
+}
+
+static
+INT
+SystemCreateTask
+    (
+        IN TASK_PRIORITY priority,
+        IN TASK_START_FUNC startFunc
+    )
+{
+    return SystemCreateTaskWithStack(priority, LargeStack, startFunc);
+}
+
+static
+INT
+SystemCreateTaskWithStackAndArgument
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_ARG_FUNC startFunc,
+        IN PVOID argument,
+        IN INT argumentLength
+    )
+{
+    if(NULL == argument || argumentLength < 0 || argumentLength > MAX_TASK_ARGUMENT_LENGTH)
+    {
+        return ERROR_ARGUMENT_INVALID;
+    }
+
+    return SystempCreateTask(priority, stackClass, (TASK_START_FUNC) startFunc, argument, argumentLength);
+}
+
+static
+INT
+SystemCreateTaskWithArgument
+    (
+        IN TASK_PRIORITY priority,
+        IN TASK_START_ARG_FUNC startFunc,
+        IN PVOID argument,
+        IN INT argumentLength
+    )
+{
+    return SystemCreateTaskWithStackAndArgument(priority, LargeStack, startFunc, argument, argumentLength);
+}
+
 static
 INT
 SystemGetCurrentTaskId
@@ -148,6 +228,70 @@ SystemReceiveMessage
     return bytesReceived;
 }
 
+static
+inline
+INT
+SystempReceiveMessageBefore
+    (
+        OUT INT* senderId,
+        OUT PVOID buffer,
+        IN INT bufferLength,
+        IN INT tick
+    )
+{
+    TASK_DESCRIPTOR* currentTask = SchedulerGetCurrentTask();
+    INT bytesReceived = SystemReceiveMessage(senderId, buffer, bufferLength);
+
+    if(SendBlockedState == currentTask->state)
+    {
+        if((INT) (tick - ClockGetTicks()) > 0)
+        {
+            ClockTimeoutReceive(currentTask, tick);
+        }
+        else
+        {
+            // The deadline has passed and nothing was waiting.  Don't block at all.
+            currentTask->state = RunningState;
+            bytesReceived = RECEIVE_TIMED_OUT;
+        }
+    }
+
+    return bytesReceived;
+}
+
+static
+INT
+SystemReceiveMessageUntil
+    (
+        OUT INT* senderId,
+        OUT PVOID buffer,
+        IN INT bufferLength,
+        IN INT tick
+    )
+{
+    // A due deadline wins over waiting messages, so that a busy
+    // receiver still gets to do its periodic work
+    if((INT) (tick - ClockGetTicks()) <= 0)
+    {
+        return RECEIVE_TIMED_OUT;
+    }
+
+    return SystempReceiveMessageBefore(senderId, buffer, bufferLength, tick);
+}
+
+static
+INT
+SystemReceiveMessageTimeout
+    (
+        OUT INT* senderId,
+        OUT PVOID buffer,
+        IN INT bufferLength,
+        IN INT ticks
+    )
+{
+    return SystempReceiveMessageBefore(senderId, buffer, bufferLength, ClockGetTicks() + ticks);
+}
+
 static
 INT
 SystemReplyMessage
@@ -186,6 +330,16 @@ SystemReplyMessage
     }
 }
 
+static
+VOID
+SystemEnablePriorityInheritance
+    (
+        VOID
+    )
+{
+    IpcEnablePriorityInheritance(SchedulerGetCurrentTask());
+}
+
 static
 INT
 SystemAwaitEvent
@@ -193,12 +347,48 @@ SystemAwaitEvent
         IN EVENT event
     )
 {
-    RT_STATUS status = InterruptAwaitEvent(SchedulerGetCurrentTask(), event);
+    UINT pendingEvents;
+    RT_STATUS status = InterruptAwaitEvent(SchedulerGetCurrentTask(), event, &pendingEvents);
 
     switch(status)
     {
         case STATUS_SUCCESS:
-            return ERROR_SUCCESS;
+            // Zero if the task blocked.  The interrupt sets the real count.
+            return pendingEvents;
+
+        case STATUS_INVALID_PARAMETER:
+            return ERROR_INVALID_EVENT;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
+static
+INT
+SystemAwaitEventData
+    (
+        IN EVENT event,
+        IN PVOID buffer,
+        IN INT bufferLength
+    )
+{
+    UINT bytesRead;
+    RT_STATUS status;
+
+    if(bufferLength <= 0)
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    status = InterruptAwaitEventData(SchedulerGetCurrentTask(), event, buffer, bufferLength, &bytesRead);
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            // Zero if the task blocked.  The interrupt sets the real count.
+            return bytesRead;
 
         case STATUS_INVALID_PARAMETER:
             return ERROR_INVALID_EVENT;
@@ -219,6 +409,21 @@ SystemQueryPerformance
 {
     RT_STATUS status = PerformanceGet(taskId, performance);
 
+    if(RT_SUCCESS(status))
+    {
+        TASK_DESCRIPTOR* td;
+
+        performance->stackSize = 0;
+        performance->stackHighWater = 0;
+
+        // Only live tasks still own their stack
+        if(RT_SUCCESS(TaskDescriptorGet(taskId, &td)) && ZombieState != td->state)
+        {
+            performance->stackSize = td->stack->size;
+            performance->stackHighWater = TaskGetStackHighWater(td);
+        }
+    }
+
     switch (status)
     {
         case STATUS_SUCCESS:
@@ -233,20 +438,301 @@ SystemQueryPerformance
     }
 }
 
+static
+INT
+SystemQueryPerformanceAll
+    (
+        OUT TASK_PERFORMANCE* performance,
+        IN INT numTasks
+    )
+{
+    INT filled = 0;
+    UINT i;
+
+    for(i = 0; i < NUM_TASKS && filled < numTasks; i++)
+    {
+        TASK_DESCRIPTOR* td = TaskDescriptorGetSlot(i);
+
+        // Skip slots that have never had a task, or whose task has exited
+        if(td->taskId < 0 || ZombieState == td->state)
+        {
+            continue;
+        }
+
+        VERIFY(RT_SUCCESS(PerformanceGet(td->taskId, &performance[filled])));
+
+        performance[filled].stackSize = td->stack->size;
+        performance[filled].stackHighWater = TaskGetStackHighWater(td);
+
+        filled++;
+    }
+
+    return filled;
+}
+
+static
+INT
+SystemDumpKernelTrace
+    (
+        IN TRACE_DUMP when
+    )
+{
+    if(TraceDumpNow != when && TraceDumpAtShutdown != when)
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    TraceRequestDump(when);
+
+    return ERROR_SUCCESS;
+}
+
+static
+INT
+SystemReadKernelTrace
+    (
+        OUT STRING buffer,
+        IN INT bufferLength
+    )
+{
+    if(NULL == buffer || bufferLength < MAX_TRACE_LINE_LENGTH)
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    return TraceRead(buffer, bufferLength);
+}
+
+static
+INT
+SystemQueryEventLatency
+    (
+        IN EVENT event,
+        OUT EVENT_LATENCY* latency
+    )
+{
+    RT_STATUS status = PerformanceGetEventLatency(event, latency);
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            return ERROR_SUCCESS;
+
+        case STATUS_FAILURE:
+            return ERROR_INVALID_EVENT;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
+static
+INT
+SystemSendMessageAt
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT tick
+    )
+{
+    TASK_DESCRIPTOR* to;
+    IPC_MESSAGE* ipcMessage;
+    RT_STATUS status = TaskDescriptorGet(taskId, &to);
+
+    if(RT_SUCCESS(status) && ZombieState == to->state)
+    {
+        status = STATUS_NOT_FOUND;
+    }
+
+    if(RT_SUCCESS(status))
+    {
+        status = IpcCreateMessage(SchedulerGetCurrentTask(),
+                                  taskId,
+                                  message,
+                                  messageLength,
+                                  &ipcMessage);
+    }
+
+    if(RT_SUCCESS(status))
+    {
+        if((INT) (tick - ClockGetTicks()) <= 0)
+        {
+            status = IpcPostMessage(ipcMessage);
+        }
+        else
+        {
+            ClockDelayMessage(ipcMessage, tick);
+        }
+    }
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            return ERROR_SUCCESS;
+
+        case STATUS_INVALID_PARAMETER:
+            return ERROR_INVALID_TASK;
+
+        case STATUS_NOT_FOUND:
+            return ERROR_DEAD_TASK;
+
+        case STATUS_BUFFER_OVERFLOW:
+            return ERROR_MESSAGE_TOO_LONG;
+
+        case STATUS_BUFFER_TOO_SMALL:
+            return ERROR_TOO_MANY_MESSAGES;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
+static
+INT
+SystemPostMessage
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength
+    )
+{
+    TASK_DESCRIPTOR* to;
+
+    if(RT_SUCCESS(TaskDescriptorGet(taskId, &to)) && IpcIsMessageQueueFull(to))
+    {
+        return ERROR_QUEUE_FULL;
+    }
+
+    return SystemSendMessageAt(taskId, message, messageLength, ClockGetTicks());
+}
+
+static
+INT
+SystemDelayedSendMessage
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    )
+{
+    return SystemSendMessageAt(taskId, message, messageLength, ClockGetTicks() + ticks);
+}
+
+static
+INT
+SystemCreateTopic
+    (
+        VOID
+    )
+{
+    INT topic;
+    RT_STATUS status = TopicCreate(&topic);
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            return topic;
+
+        case STATUS_BUFFER_TOO_SMALL:
+            return ERROR_OUT_OF_TOPICS;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
+static
+INT
+SystemSubscribe
+    (
+        IN INT topic,
+        OUT PVOID buffer,
+        IN INT bufferLength
+    )
+{
+    INT bytesReceived;
+    RT_STATUS status = TopicSubscribe(SchedulerGetCurrentTask(), topic, buffer, bufferLength, &bytesReceived);
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            return bytesReceived;
+
+        case STATUS_INVALID_PARAMETER:
+            return ERROR_INVALID_TOPIC;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
+static
+INT
+SystemPublish
+    (
+        IN INT topic,
+        IN PVOID message,
+        IN INT messageLength
+    )
+{
+    INT subscribersWoken;
+    RT_STATUS status = TopicPublish(SchedulerGetCurrentTask(),
+                                    topic,
+                                    message,
+                                    messageLength,
+                                    &subscribersWoken);
+
+    switch(status)
+    {
+        case STATUS_SUCCESS:
+            return subscribersWoken;
+
+        case STATUS_INVALID_PARAMETER:
+            return ERROR_INVALID_TOPIC;
+
+        default:
+            ASSERT(FALSE);
+            return 0;
+    }
+}
+
 VOID
 SyscallInit
     (
         VOID
     )
 {
-    g_systemCallTable[0] = (UINT) SystemCreateTask;
-    g_systemCallTable[1] = (UINT) SystemGetCurrentTaskId;
-    g_systemCallTable[2] = (UINT) SystemGetCurrentParentTaskId;
-    g_systemCallTable[3] = (UINT) SystemPassCurrentTask;
-    g_systemCallTable[4] = (UINT) SystemDestroyCurrentTask;
-    g_systemCallTable[5] = (UINT) SystemSendMessage;
-    g_systemCallTable[6] = (UINT) SystemReceiveMessage;
-    g_systemCallTable[7] = (UINT) SystemReplyMessage;
-    g_systemCallTable[8] = (UINT) SystemAwaitEvent;
-    g_systemCallTable[9] = (UINT) SystemQueryPerformance;
+    g_systemCallTable[CreateSystemCall] = SystemCreateTask;
+    g_systemCallTable[MyTidSystemCall] = SystemGetCurrentTaskId;
+    g_systemCallTable[MyParentTidSystemCall] = SystemGetCurrentParentTaskId;
+    g_systemCallTable[PassSystemCall] = SystemPassCurrentTask;
+    g_systemCallTable[ExitSystemCall] = SystemDestroyCurrentTask;
+    g_systemCallTable[SendSystemCall] = SystemSendMessage;
+    g_systemCallTable[ReceiveSystemCall] = SystemReceiveMessage;
+    g_systemCallTable[ReplySystemCall] = SystemReplyMessage;
+    g_systemCallTable[AwaitEventSystemCall] = SystemAwaitEvent;
+    g_systemCallTable[QueryPerformanceSystemCall] = SystemQueryPerformance;
+    g_systemCallTable[CreateExSystemCall] = SystemCreateTaskWithStack;
+    g_systemCallTable[DumpKernelTraceSystemCall] = SystemDumpKernelTrace;
+    g_systemCallTable[QueryEventLatencySystemCall] = SystemQueryEventLatency;
+    g_systemCallTable[DelayedSendSystemCall] = SystemDelayedSendMessage;
+    g_systemCallTable[SendAtSystemCall] = SystemSendMessageAt;
+    g_systemCallTable[ReceiveTimeoutSystemCall] = SystemReceiveMessageTimeout;
+    g_systemCallTable[PostSystemCall] = SystemPostMessage;
+    g_systemCallTable[CreateTopicSystemCall] = SystemCreateTopic;
+    g_systemCallTable[SubscribeSystemCall] = SystemSubscribe;
+    g_systemCallTable[PublishSystemCall] = SystemPublish;
+    g_systemCallTable[AwaitEventDataSystemCall] = SystemAwaitEventData;
+    g_systemCallTable[QueryPerformanceAllSystemCall] = SystemQueryPerformanceAll;
+    g_systemCallTable[EnablePriorityInheritanceSystemCall] = SystemEnablePriorityInheritance;
+    g_systemCallTable[CreateWithArgSystemCall] = SystemCreateTaskWithArgument;
+    g_systemCallTable[CreateExWithArgSystemCall] = SystemCreateTaskWithStackAndArgument;
+    g_systemCallTable[ReadKernelTraceSystemCall] = SystemReadKernelTrace;
+    g_systemCallTable[ReceiveUntilSystemCall] = SystemReceiveMessageUntil;
 }
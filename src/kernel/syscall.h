@@ -2,6 +2,14 @@
 
 #include <rt.h>
 
+// The system call the running task last trapped in with.
+// Set by the trap handler, so the kernel can tell system
+// calls apart from interrupts once KernelLeave returns.
+extern UINT g_lastSystemCall;
+
+// Timer3 when the running task last trapped in with a system call
+extern UINT g_lastSystemCallTicks;
+
 VOID
 SyscallInit
     (
@@ -4,10 +4,17 @@
 #include <rtosc/string.h>
 
 #include "ipc.h"
+#include "performance.h"
 #include "scheduler.h"
 #include "stack.h"
+#include "trace.h"
+
+#if !NLOCAL
+#include "host/host.h"
+#endif
 
 #define CANARY 0x12341234
+#define STACK_PAINT 0x5AC4F00D
 #define TASK_INITIAL_CPSR 0x10
 #define RETURN_VALUE_OFFSET 8
 
@@ -35,23 +42,61 @@ TaskpIsPriorityValid
     return priority && !(priority & (priority - 1));
 }
 
+static
+inline
+VOID
+TaskpPaintStack
+    (
+        IN STACK* stack
+    )
+{
+    UINT* p = stack->top;
+    UINT* end = ptr_add(stack->top, stack->size);
+
+    // Whatever the task never touches keeps the paint,
+    // which is how TaskGetStackHighWater finds its peak
+    while(p < end)
+    {
+        *(p++) = STACK_PAINT;
+    }
+}
+
 static
 inline
 UINT*
 TaskpSetupStack
     (
         IN STACK* stack,
-        IN TASK_START_FUNC startFunc
+        IN TASK_START_FUNC startFunc,
+        IN PVOID argument,
+        IN UINT argumentLength
     )
 {
-    UINT* stackPointer = ((UINT*) ptr_add(stack->top, stack->size)) - sizeof(UINT);
+    PVOID stackEnd = ptr_add(stack->top, stack->size);
+    PVOID argumentCopy = NULL;
+
+    // The argument lives at the very end of the stack.  Rounding its
+    // size up keeps the stack below it aligned for either build.
+    if(NULL != argument)
+    {
+        stackEnd = ptr_add(stackEnd, -1 * (INT) ((argumentLength + 15) & ~15));
+        argumentCopy = stackEnd;
+        RtMemcpy(argumentCopy, argument, argumentLength);
+    }
+
+#if NLOCAL
+    UINT* stackPointer = ((UINT*) stackEnd) - sizeof(UINT);
 
     *stackPointer = (UINT) Exit;
+    *(stackPointer - 13) = (UINT) argumentCopy;
     *(stackPointer - 14) = TASK_INITIAL_CPSR;
     *(stackPointer - 15) = (UINT) startFunc;
     stackPointer -= 15;
 
     return stackPointer;
+#else
+    return TrapSetupStack(stack, stackEnd, startFunc, argumentCopy);
+#endif
 }
 
 RT_STATUS
@@ -59,7 +104,10 @@ TaskCreate
     (
         IN TASK_DESCRIPTOR* parent,
         IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
         IN TASK_START_FUNC startFunc,
+        IN PVOID argument,
+        IN UINT argumentLength,
         OUT TASK_DESCRIPTOR** td
     )
 {
@@ -73,24 +121,37 @@ TaskCreate
 
         if(RT_SUCCESS(status))
         {
-            status = StackAllocate(&newTd->stack);
+            status = StackAllocate(stackClass, &newTd->stack);
 
             if(RT_SUCCESS(status))
             {
+                PerformanceResetTask(newTd->taskId);
+
                 newTd->parentTaskId = NULL == parent ? 0 : parent->taskId;
                 newTd->state = ReadyState;
                 newTd->priority = priority;
-                newTd->stackPointer = TaskpSetupStack(newTd->stack, startFunc);
+                newTd->basePriority = priority;
+                newTd->inheritPriority = FALSE;
+                TaskpPaintStack(newTd->stack);
+                newTd->stackPointer = TaskpSetupStack(newTd->stack, startFunc, argument, argumentLength);
                 *(newTd->stack->top) = CANARY;
+                newTd->wokenEvent = NumEvent;
+                newTd->timeoutPending = FALSE;
                 IpcInitializeMailbox(newTd);
 
                 status = SchedulerAddTask(newTd);
 
                 if(RT_SUCCESS(status))
                 {
+                    TraceRecord(TraceTaskCreate, newTd->taskId, newTd->parentTaskId);
                     *td = newTd;
                 }
             }
+            else
+            {
+                // Out of stacks of this class
+                VERIFY(RT_SUCCESS(TaskDescriptorDeallocate(newTd)));
+            }
         }
     }
     else
@@ -122,6 +183,26 @@ TaskValidate
     return CANARY == *(task->stack->top);
 }
 
+UINT
+TaskGetStackHighWater
+    (
+        IN TASK_DESCRIPTOR* td
+    )
+{
+    STACK* stack = td->stack;
+    UINT* end = ptr_add(stack->top, stack->size);
+    UINT* p = stack->top + 1;
+
+    // Stacks grow down, so the first word from the bottom
+    // that lost its paint is the deepest the task has been
+    while(p < end && STACK_PAINT == *p)
+    {
+        p++;
+    }
+
+    return (UINTPTR) end - (UINTPTR) p;
+}
+
 VOID
 TaskSetReturnValue
     (
@@ -140,9 +221,7 @@ TaskStoreAsyncParameter
         IN UINT size
     )
 {
-    RtMemcpy(ptr_add(td->stackPointer, -1 * (size + sizeof(UINT))),
-             parameter,
-             size);
+    RtMemcpy(TaskGetAsyncParameter(td, size), parameter, size);
 }
 
 VOID
@@ -153,7 +232,5 @@ TaskRetrieveAsyncParameter
         IN UINT size
     )
 {
-    RtMemcpy(parameter,
-             ptr_add(td->stackPointer, -1 * (size + sizeof(UINT))),
-             size);
+    RtMemcpy(parameter, TaskGetAsyncParameter(td, size), size);
 }
@@ -9,12 +9,17 @@ TaskInit
         VOID
     );
 
+// Unless argument is NULL, argumentLength bytes of it are copied on
+// to the new task's stack and startFunc is passed the copy
 RT_STATUS
 TaskCreate
     (
         IN TASK_DESCRIPTOR* parent,
         IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
         IN TASK_START_FUNC startFunc,
+        IN PVOID argument,
+        IN UINT argumentLength,
         OUT TASK_DESCRIPTOR** td
     );
 
@@ -30,6 +35,12 @@ TaskValidate
         IN TASK_DESCRIPTOR* td
     );
 
+UINT
+TaskGetStackHighWater
+    (
+        IN TASK_DESCRIPTOR* td
+    );
+
 VOID
 TaskSetReturnValue
     (
@@ -37,6 +48,21 @@ TaskSetReturnValue
         IN INT returnValue
     );
 
+// Async parameters live just below a blocked task's saved context.
+// Returns where a parameter of the given size is kept, so callers
+// can read and write it in place instead of copying it around.
+static
+inline
+PVOID
+TaskGetAsyncParameter
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN UINT size
+    )
+{
+    return ptr_add(td->stackPointer, -1 * (size + sizeof(UINT)));
+}
+
 VOID
 TaskStoreAsyncParameter
     (
@@ -100,3 +100,12 @@ TaskDescriptorGet
         return STATUS_INVALID_PARAMETER;
     }
 }
+
+TASK_DESCRIPTOR*
+TaskDescriptorGetSlot
+    (
+        IN UINT index
+    )
+{
+    return &g_taskDescriptors[index % NUM_TASKS];
+}
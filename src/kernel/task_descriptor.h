@@ -13,19 +13,47 @@ typedef enum _TASK_STATE
     ReceiveBlockedState,
     ReplyBlockedState,
     EventBlockedState,
+    SubscribeBlockedState,
     ZombieState
 } TASK_STATE;
 
+// trap.asm reads the first four fields directly
 typedef struct _TASK_DESCRIPTOR {
     UINT* stackPointer;
     INT taskId;
     INT parentTaskId;
-    TASK_PRIORITY priority;
+    TASK_PRIORITY priority;         // What the scheduler runs the task at
+    TASK_PRIORITY basePriority;     // What the task was created with
     TASK_STATE state;
-    RT_CIRCULAR_BUFFER mailbox;
     STACK* stack;
+    struct _TASK_DESCRIPTOR* nextReady;
+    struct _TASK_DESCRIPTOR* mailboxHead;
+    struct _TASK_DESCRIPTOR* mailboxTail;
+    struct _TASK_DESCRIPTOR* nextSender;
+    struct _TASK_DESCRIPTOR* nextSubscriber;
+    struct _TASK_DESCRIPTOR* nextEventWaiter;
+    struct _IPC_MESSAGE* messageHead;   // Delivered without a Send()
+    struct _IPC_MESSAGE* messageTail;
+    UINT messageCount;
+    struct _TASK_DESCRIPTOR* nextTimeout;   // In ReceiveTimeout(), soonest first
+    UINT timeoutTick;
+    BOOLEAN timeoutPending;
+    EVENT wokenEvent;   // NumEvent unless an interrupt just woke the task
+    UINT wokenTicks;
+    UINT clientPriorities;              // Priorities of the tasks in Send() to this one
+    UCHAR clientCounts[NumPriority];    // How many of them are at each priority
+    BOOLEAN inheritPriority;            // Run at the highest client priority that outranks ours
+    struct _TASK_DESCRIPTOR* server;    // Who has our priority while we are in Send()
+    TASK_PRIORITY donatedPriority;
 } TASK_DESCRIPTOR;
 
+#if NLOCAL
+// The offsets trap.asm loads from
+compile_assert(TaskDescriptorTaskIdOffset, 4 == __builtin_offsetof(TASK_DESCRIPTOR, taskId));
+compile_assert(TaskDescriptorParentTaskIdOffset, 8 == __builtin_offsetof(TASK_DESCRIPTOR, parentTaskId));
+compile_assert(TaskDescriptorPriorityOffset, 12 == __builtin_offsetof(TASK_DESCRIPTOR, priority));
+#endif
+
 RT_STATUS
 TaskDescriptorInit
     (
@@ -50,3 +78,10 @@ TaskDescriptorGet
         IN INT taskId,
         OUT TASK_DESCRIPTOR** td
     );
+
+// The descriptor in slot index, whether or not a task owns it
+TASK_DESCRIPTOR*
+TaskDescriptorGetSlot
+    (
+        IN UINT index
+    );
@@ -0,0 +1,231 @@
+#include "topic.h"
+
+#include <rtosc/assert.h>
+#include <rtosc/string.h>
+#include "performance.h"
+#include "scheduler.h"
+#include "task.h"
+
+#define NUM_TOPICS 32
+
+typedef struct _TOPIC_MESSAGE
+{
+    INT length;
+    UCHAR data[MAX_BUFFERED_TOPIC_MESSAGE_LENGTH];
+} TOPIC_MESSAGE;
+
+// Where a task is up to in a topic.  The task id tells a new
+// owner of the slot apart from the task that subscribed before it.
+typedef struct _TOPIC_POSITION
+{
+    INT taskId;
+    UINT nextSequence;
+} TOPIC_POSITION;
+
+// Tasks blocked in Subscribe(), in the order they subscribed
+typedef struct _TOPIC
+{
+    TASK_DESCRIPTOR* subscriberHead;
+    TASK_DESCRIPTOR* subscriberTail;
+    UINT nextSequence;
+
+    // Lets a subscriber that was busy during a publish catch up
+    TOPIC_MESSAGE backlog[TOPIC_BACKLOG_LENGTH];
+    TOPIC_POSITION positions[NUM_TASKS];
+} TOPIC;
+
+// Kept on a Subscribe() blocked task's stack until the next Publish()
+typedef struct _PENDING_SUBSCRIBE
+{
+    PVOID buffer;
+    INT bufferLength;
+} PENDING_SUBSCRIBE;
+
+static TOPIC g_topics[NUM_TOPICS];
+static INT g_numTopics;
+
+static
+inline
+BOOLEAN
+TopicpIsValid
+    (
+        IN INT topic
+    )
+{
+    return 0 <= topic && topic < g_numTopics;
+}
+
+VOID
+TopicInit
+    (
+        VOID
+    )
+{
+    g_numTopics = 0;
+}
+
+RT_STATUS
+TopicCreate
+    (
+        OUT INT* topic
+    )
+{
+    // Topics live as long as the kernel, so there is no need to free them
+    if(g_numTopics < NUM_TOPICS)
+    {
+        TOPIC* newTopic = &g_topics[g_numTopics];
+
+        newTopic->subscriberHead = NULL;
+        newTopic->subscriberTail = NULL;
+        newTopic->nextSequence = 0;
+        RtMemset(newTopic->positions, sizeof(newTopic->positions), 0xFF);
+
+        *topic = g_numTopics++;
+
+        return STATUS_SUCCESS;
+    }
+    else
+    {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+}
+
+RT_STATUS
+TopicSubscribe
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN INT topic,
+        IN PVOID buffer,
+        IN INT bufferLength,
+        OUT INT* bytesReceived
+    )
+{
+    if(TopicpIsValid(topic))
+    {
+        TOPIC* subscribedTopic = &g_topics[topic];
+        TOPIC_POSITION* position = &subscribedTopic->positions[td->taskId % NUM_TASKS];
+
+        // A task's first Subscribe() waits for the next Publish()
+        if(position->taskId != td->taskId)
+        {
+            position->taskId = td->taskId;
+            position->nextSequence = subscribedTopic->nextSequence;
+        }
+
+        if(position->nextSequence != subscribedTopic->nextSequence)
+        {
+            UINT oldestSequence = subscribedTopic->nextSequence - TOPIC_BACKLOG_LENGTH;
+            TOPIC_MESSAGE* missedMessage;
+            INT length;
+
+            // Anything older than the backlog is gone
+            if((INT) (position->nextSequence - oldestSequence) < 0)
+            {
+                position->nextSequence = oldestSequence;
+            }
+
+            missedMessage = &subscribedTopic->backlog[position->nextSequence % TOPIC_BACKLOG_LENGTH];
+            length = min(missedMessage->length, bufferLength);
+
+            // Only counted against the subscriber, since the publisher has moved on
+            RtMemcpy(buffer, missedMessage->data, length);
+            PerformanceGetCounters(td->taskId)->bytesReceived += length;
+
+            position->nextSequence++;
+            *bytesReceived = length;
+        }
+        else
+        {
+            PENDING_SUBSCRIBE* pendingSubscribe = TaskGetAsyncParameter(td, sizeof(*pendingSubscribe));
+
+            pendingSubscribe->buffer = buffer;
+            pendingSubscribe->bufferLength = bufferLength;
+
+            td->state = SubscribeBlockedState;
+            td->nextSubscriber = NULL;
+
+            if(NULL == subscribedTopic->subscriberHead)
+            {
+                subscribedTopic->subscriberHead = td;
+            }
+            else
+            {
+                subscribedTopic->subscriberTail->nextSubscriber = td;
+            }
+
+            subscribedTopic->subscriberTail = td;
+
+            // The real value comes from Publish()
+            *bytesReceived = 0;
+        }
+
+        return STATUS_SUCCESS;
+    }
+    else
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+}
+
+RT_STATUS
+TopicPublish
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN INT topic,
+        IN PVOID message,
+        IN INT messageLength,
+        OUT INT* subscribersWoken
+    )
+{
+    if(TopicpIsValid(topic))
+    {
+        TOPIC* publishedTopic = &g_topics[topic];
+        TASK_DESCRIPTOR* subscriber = publishedTopic->subscriberHead;
+        INT woken = 0;
+
+        // Subscribing again from here on waits for the next Publish()
+        publishedTopic->subscriberHead = NULL;
+        publishedTopic->subscriberTail = NULL;
+
+        // Long messages only reach the tasks that are already waiting
+        if(messageLength <= MAX_BUFFERED_TOPIC_MESSAGE_LENGTH)
+        {
+            TOPIC_MESSAGE* bufferedMessage = &publishedTopic->backlog[publishedTopic->nextSequence % TOPIC_BACKLOG_LENGTH];
+
+            bufferedMessage->length = messageLength;
+            RtMemcpy(bufferedMessage->data, message, messageLength);
+
+            publishedTopic->nextSequence++;
+        }
+
+        while(NULL != subscriber)
+        {
+            TASK_DESCRIPTOR* next = subscriber->nextSubscriber;
+            PENDING_SUBSCRIBE* pendingSubscribe = TaskGetAsyncParameter(subscriber, sizeof(*pendingSubscribe));
+            INT length = min(messageLength, pendingSubscribe->bufferLength);
+
+            RtMemcpy(pendingSubscribe->buffer, message, length);
+            PerformanceGetCounters(from->taskId)->bytesSent += length;
+            PerformanceGetCounters(subscriber->taskId)->bytesReceived += length;
+
+            // The subscriber has now seen everything up to here
+            publishedTopic->positions[subscriber->taskId % NUM_TASKS].nextSequence = publishedTopic->nextSequence;
+
+            // Finish the Subscribe() system call
+            TaskSetReturnValue(subscriber, length);
+            subscriber->state = ReadyState;
+            VERIFY(RT_SUCCESS(SchedulerAddTask(subscriber)));
+
+            subscriber = next;
+            woken++;
+        }
+
+        *subscribersWoken = woken;
+
+        return STATUS_SUCCESS;
+    }
+    else
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <rt.h>
+#include "task_descriptor.h"
+
+VOID
+TopicInit
+    (
+        VOID
+    );
+
+RT_STATUS
+TopicCreate
+    (
+        OUT INT* topic
+    );
+
+RT_STATUS
+TopicSubscribe
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN INT topic,
+        IN PVOID buffer,
+        IN INT bufferLength,
+        OUT INT* bytesReceived
+    );
+
+RT_STATUS
+TopicPublish
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN INT topic,
+        IN PVOID message,
+        IN INT messageLength,
+        OUT INT* subscribersWoken
+    );
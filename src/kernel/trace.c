@@ -0,0 +1,171 @@
+#include "trace.h"
+
+#include <bwio/bwio.h>
+#include <rtosc/string.h>
+
+TRACE_RECORD g_traceBuffer[TRACE_BUFFER_SIZE];
+UINT g_traceNext;
+
+static BOOLEAN g_dumpAtShutdown;
+
+// A copy of the buffer for TraceRead() to hand out.  Line 0 is the
+// #TRACE header, lines 1 to count are records and the line after is #END.
+static TRACE_RECORD g_traceSnapshot[TRACE_BUFFER_SIZE];
+static UINT g_snapshotCount;
+static UINT g_snapshotDropped;
+static UINT g_snapshotLine;
+
+static
+VOID
+TracepDump
+    (
+        VOID
+    )
+{
+    UINT count = min(g_traceNext, TRACE_BUFFER_SIZE);
+    UINT i;
+
+    // Plain hex lines survive terminals and log captures.
+    // tools/trace_decode.py turns them in to a timeline.
+    bwprintf(BWCOM2, "\r\n#TRACE %d %d\r\n", count, g_traceNext - count);
+
+    for(i = g_traceNext - count; i != g_traceNext; i++)
+    {
+        TRACE_RECORD* record = &g_traceBuffer[i & (TRACE_BUFFER_SIZE - 1)];
+
+        bwputr(BWCOM2, record->ticks);
+        bwputr(BWCOM2, record->header);
+        bwputr(BWCOM2, record->data);
+        bwputstr(BWCOM2, "\r\n");
+    }
+
+    bwputstr(BWCOM2, "#END\r\n");
+
+    // Start over so the next dump only has new events
+    g_traceNext = 0;
+}
+
+static
+VOID
+TracepSnapshot
+    (
+        VOID
+    )
+{
+    UINT count = min(g_traceNext, TRACE_BUFFER_SIZE);
+    UINT first = (g_traceNext - count) & (TRACE_BUFFER_SIZE - 1);
+    UINT beforeWrap = min(count, TRACE_BUFFER_SIZE - first);
+
+    // Unroll the ring so the copy starts with the oldest record
+    RtMemcpy(g_traceSnapshot, &g_traceBuffer[first], beforeWrap * sizeof(TRACE_RECORD));
+    RtMemcpy(&g_traceSnapshot[beforeWrap], g_traceBuffer, (count - beforeWrap) * sizeof(TRACE_RECORD));
+
+    g_snapshotCount = count;
+    g_snapshotDropped = g_traceNext - count;
+    g_snapshotLine = 0;
+
+    // Start over so the next dump only has new events
+    g_traceNext = 0;
+}
+
+static
+inline
+INT
+TracepFormatLine
+    (
+        IN UINT line,
+        OUT STRING buffer,
+        IN INT bufferLength
+    )
+{
+    if(0 == line)
+    {
+        return RtStrPrintFormatted(buffer, bufferLength, "\r\n#TRACE %d %d\r\n", g_snapshotCount, g_snapshotDropped);
+    }
+    else if(line <= g_snapshotCount)
+    {
+        TRACE_RECORD* record = &g_traceSnapshot[line - 1];
+
+        return RtStrPrintFormatted(buffer,
+                                   bufferLength,
+                                   "%08x %08x %08x\r\n",
+                                   record->ticks,
+                                   record->header,
+                                   record->data);
+    }
+    else
+    {
+        return RtStrPrintFormatted(buffer, bufferLength, "#END\r\n");
+    }
+}
+
+VOID
+TraceInit
+    (
+        VOID
+    )
+{
+    g_traceNext = 0;
+    g_dumpAtShutdown = FALSE;
+    g_snapshotCount = 0;
+    g_snapshotDropped = 0;
+
+    // Past #END, so there is nothing to read until someone asks for a dump
+    g_snapshotLine = g_snapshotCount + 2;
+}
+
+VOID
+TraceRequestDump
+    (
+        IN TRACE_DUMP when
+    )
+{
+    if(TraceDumpNow == when)
+    {
+        TracepSnapshot();
+    }
+    else
+    {
+        g_dumpAtShutdown = TRUE;
+    }
+}
+
+VOID
+TraceShutdown
+    (
+        VOID
+    )
+{
+    if(g_dumpAtShutdown)
+    {
+        TracepDump();
+    }
+}
+
+INT
+TraceRead
+    (
+        OUT STRING buffer,
+        IN INT bufferLength
+    )
+{
+    INT length = 0;
+
+    // Only hand out whole lines
+    while(g_snapshotLine <= g_snapshotCount + 1)
+    {
+        CHAR line[MAX_TRACE_LINE_LENGTH];
+        INT lineLength = TracepFormatLine(g_snapshotLine, line, sizeof(line));
+
+        if(length + lineLength > bufferLength)
+        {
+            break;
+        }
+
+        RtMemcpy(&buffer[length], line, lineLength);
+        length += lineLength;
+        g_snapshotLine++;
+    }
+
+    return length;
+}
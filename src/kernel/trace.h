@@ -0,0 +1,87 @@
+#pragma once
+
+#include <rt.h>
+#include <rtkernel.h>
+#include <ts7200.h>
+
+// Must be a power of 2
+#define TRACE_BUFFER_SIZE 4096
+
+typedef enum _TRACE_EVENT
+{
+    TraceTaskCreate = 1,        // data is the parent's task id
+    TraceContextSwitch,         // data is the task's priority
+    TraceSystemCallEnter,       // data is the system call number
+    TraceSystemCallExit,        // data is the system call number
+    TraceInterrupt,             // task is the one that was interrupted
+    TraceEventWakeup            // data is the EVENT
+} TRACE_EVENT;
+
+typedef struct _TRACE_RECORD
+{
+    UINT ticks;
+    UINT header;    // Event in the top 8 bits, task id in the rest
+    UINT data;
+} TRACE_RECORD;
+
+extern TRACE_RECORD g_traceBuffer[TRACE_BUFFER_SIZE];
+extern UINT g_traceNext;
+
+// A handful of stores, so tracing can stay on in release builds
+static
+inline
+VOID
+TraceRecordAt
+    (
+        IN TRACE_EVENT event,
+        IN INT taskId,
+        IN UINT data,
+        IN UINT ticks
+    )
+{
+    TRACE_RECORD* record = &g_traceBuffer[g_traceNext++ & (TRACE_BUFFER_SIZE - 1)];
+
+    record->ticks = ticks;
+    record->header = (event << 24) | (taskId & 0xFFFFFF);
+    record->data = data;
+}
+
+static
+inline
+VOID
+TraceRecord
+    (
+        IN TRACE_EVENT event,
+        IN INT taskId,
+        IN UINT data
+    )
+{
+    TraceRecordAt(event, taskId, data, *(volatile UINT*) (TIMER3_BASE + VAL_OFFSET));
+}
+
+VOID
+TraceInit
+    (
+        VOID
+    );
+
+VOID
+TraceRequestDump
+    (
+        IN TRACE_DUMP when
+    );
+
+// Copies whole lines of the last TraceDumpNow snapshot in to buffer.
+// Returns the number of characters copied, 0 once #END is out.
+INT
+TraceRead
+    (
+        OUT STRING buffer,
+        IN INT bufferLength
+    );
+
+VOID
+TraceShutdown
+    (
+        VOID
+    );
@@ -12,6 +12,46 @@ TrapInstallHandler:
 
 .globl TrapEnter
 TrapEnter:
+.ifndef NTRAP_FAST_PATH
+    /* MyTid(), MyParentTid() and Pass() with nobody to pass to neither */
+    /* block nor reschedule.  Answer them without saving any context. */
+    /* The system call stubs are function calls, so r1-r3 and r12 are */
+    /* the caller's to lose.  These calls skip the performance counters */
+    /* and the kernel trace.  task_descriptor.h checks the offsets used. */
+    /* Assembling with --defsym NTRAP_FAST_PATH=1 turns this off. */
+
+    /* Grab the system call number from the swi instruction */
+    ldr r12, [lr, #-4]
+    bic r12, r12, #0xFF000000
+
+    /* MyTid is 1, MyParentTid is 2 and Pass is 3 */
+    sub r12, r12, #1
+    cmp r12, #2
+    bhi TrappSlowPath
+
+    /* Get the current task */
+    ldr r1, =g_currentTd
+    ldr r1, [r1]
+
+    /* MyTid() returns the task id, 4 bytes in to the task descriptor */
+    cmp r12, #1
+    ldrlo r0, [r1, #4]
+    movlos pc, lr
+
+    /* MyParentTid() returns the parent's id, 8 bytes in */
+    ldreq r0, [r1, #8]
+    moveqs pc, lr
+
+    /* Pass() only has to switch tasks if something is ready */
+    /* at the task's priority (12 bytes in) or higher */
+    ldr r2, =g_readyPriorities
+    ldr r2, [r2]
+    ldr r3, [r1, #12]
+    cmp r2, r3
+    movlos pc, lr
+.endif
+
+TrappSlowPath:
     /* DO NOT CLOBBER R0-R4 */
     /* THEY HAVE THE SYSTEM CALL PARAMETERS */
 
@@ -59,6 +99,16 @@ TrapEnter:
     /* Isolate the system call number */
     bic r5, r5, #0xFF000000
 
+    /* Remember the system call for the performance counters */
+    ldr r6, =g_lastSystemCall
+    str r5, [r6]
+
+    /* Timestamp it for the kernel tracer (Timer3 value register) */
+    ldr r6, =0x80810084
+    ldr r6, [r6]
+    ldr r7, =g_lastSystemCallTicks
+    str r6, [r7]
+
     /* Convert system call number to table offset */
     mov r6, #4
     mul r7, r6, r5
@@ -2,14 +2,11 @@
 
 #include <rtosc/assert.h>
 #include <rtosc/linked_list.h>
+#include <rtosc/string.h>
+#include <rtkernel.h>
 #include <rtos.h>
-#include <ts7200.h>
 
-#include "courier.h"
-
-#define CLOCK_SERVER_NAME "clk"
-
-#define TIMER_CLEAR(timerBase) ((volatile UINT*)((timerBase) + CLR_OFFSET))
+#include "services.h"
 
 typedef enum _CLOCK_SERVER_REQUEST_TYPE
 {
@@ -41,20 +38,32 @@ ClockNotifierpTask
         VOID
     )
 {
-    CLOCK_SERVER_REQUEST notifyRequest = { TickRequest };
-
-    CourierCreateTask(Priority30, MyTid(), MyParentTid());
+    CLOCK_SERVER_REQUEST notifyRequest = { TickRequest, 0 };
+    INT clockServerId = MyParentTid();
 
     while(1)
     {
-        // Wait for the event
-        AwaitEvent(ClockEvent);
+        INT ticks;
+        INT status;
 
-        // Acknowledge the interrupt
-        *TIMER_CLEAR(TIMER2_BASE) = TRUE;
+        // Wait for the event.  The kernel counts any ticks we were too busy to see.
+        ticks = AwaitEvent(ClockEvent);
+        ASSERT(ticks > 0);
 
-        // Send the event to the clock server
-        CourierPickup(&notifyRequest, sizeof(notifyRequest));
+        // Send the event to the clock server without waiting on it
+        notifyRequest.ticks += ticks;
+        status = Post(clockServerId, &notifyRequest, sizeof(notifyRequest));
+
+        if(SUCCESSFUL(status))
+        {
+            notifyRequest.ticks = 0;
+        }
+        else
+        {
+            // Waiting would need the clock server.  Hold on to the
+            // ticks and hand them over with the next one instead.
+            ASSERT(POST_OUT_OF_MESSAGES == status || POST_QUEUE_FULL == status);
+        }
     }
 }
 
@@ -132,9 +141,8 @@ ClockServerpDelayTask
     }
 }
 
-static
 VOID
-ClockServerpTask
+ClockServerTask
     (
         VOID
     )
@@ -145,8 +153,7 @@ ClockServerpTask
 
     RtLinkedListInit(&delayedTasks);
 
-    VERIFY(SUCCESSFUL(RegisterAs(CLOCK_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestSystemPriority, ClockNotifierpTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestSystemPriority, SmallStack, ClockNotifierpTask)));
 
     while (1)
     {
@@ -158,8 +165,7 @@ ClockServerpTask
         switch (request.type)
         {
             case TickRequest:
-                Reply(taskId, NULL, 0);
-                currentTick++;
+                currentTick += request.ticks;
                 VERIFY(RT_SUCCESS(ClockServerpUnblockDelayedTasks(&delayedTasks, currentTick)));
                 break;
 
@@ -195,15 +201,6 @@ ClockServerpTask
     }
 }
 
-VOID
-ClockServerCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority29, ClockServerpTask)));
-}
-
 static
 INT
 ClockServerSendRequest
@@ -211,7 +208,7 @@ ClockServerSendRequest
         IN CLOCK_SERVER_REQUEST* request
     )
 {
-    INT clockServerTaskId = WhoIs(CLOCK_SERVER_NAME);
+    INT clockServerTaskId = g_osServiceIds[ClockService];
     INT response;
     INT status = Send(clockServerTaskId, 
                       request, 
@@ -251,3 +248,133 @@ DelayUntil
     CLOCK_SERVER_REQUEST request = { DelayUntilRequest, ticks };
     return ClockServerSendRequest(&request);
 }
+
+INT
+PostRetry
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength
+    )
+{
+    INT status = Post(taskId, message, messageLength);
+
+    // Buffers free up as receivers drain their queues
+    while(POST_OUT_OF_MESSAGES == status || POST_QUEUE_FULL == status)
+    {
+        VERIFY(SUCCESSFUL(Delay(1)));
+        status = Post(taskId, message, messageLength);
+    }
+
+    return status;
+}
+
+VOID
+DeferredSendsInit
+    (
+        OUT DEFERRED_SENDS* deferred
+    )
+{
+    deferred->taskId = MyTid();
+    deferred->count = 0;
+}
+
+INT
+DelayedSendSelf
+    (
+        IN DEFERRED_SENDS* deferred,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    )
+{
+    // Work out the delivery time once, so retries don't push it back
+    INT tick = Time() + ticks;
+    INT status = POST_OUT_OF_MESSAGES;
+
+    // Anything already deferred has to go first
+    if(0 == deferred->count)
+    {
+        status = SendAt(deferred->taskId, message, messageLength, tick);
+    }
+
+    if(POST_OUT_OF_MESSAGES == status && deferred->count < MAX_DEFERRED_SENDS)
+    {
+        DEFERRED_SEND* send = &deferred->sends[deferred->count++];
+
+        ASSERT(messageLength <= sizeof(send->message));
+
+        send->tick = tick;
+        send->messageLength = messageLength;
+        RtMemcpy(send->message, message, messageLength);
+
+        status = 0;
+    }
+
+    return status;
+}
+
+static
+VOID
+ClockServerpRetryDeferredSends
+    (
+        IN DEFERRED_SENDS* deferred
+    )
+{
+    UINT sent = 0;
+    UINT i;
+
+    while(sent < deferred->count)
+    {
+        DEFERRED_SEND* send = &deferred->sends[sent];
+        INT status = SendAt(deferred->taskId, send->message, send->messageLength, send->tick);
+
+        if(POST_OUT_OF_MESSAGES == status)
+        {
+            break;
+        }
+
+        VERIFY(SUCCESSFUL(status));
+        sent++;
+    }
+
+    // Keep the rest in order
+    for(i = sent; sent > 0 && i < deferred->count; i++)
+    {
+        RtMemcpy(&deferred->sends[i - sent], &deferred->sends[i], sizeof(deferred->sends[i]));
+    }
+
+    deferred->count -= sent;
+}
+
+INT
+ReceiveDeferred
+    (
+        IN DEFERRED_SENDS* deferred,
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength
+    )
+{
+    INT status;
+
+    ClockServerpRetryDeferredSends(deferred);
+
+    if(0 == deferred->count)
+    {
+        return Receive(taskId, message, messageLength);
+    }
+
+    // Every request we take in may be one of ours freeing its buffer
+    while(RECEIVE_TIMED_OUT == (status = ReceiveTimeout(taskId, message, messageLength, 1)))
+    {
+        ClockServerpRetryDeferredSends(deferred);
+
+        if(0 == deferred->count)
+        {
+            return Receive(taskId, message, messageLength);
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,301 @@
+#include <rt.h>
+#include <rtkernel.h>
+
+// Local builds have no swi instruction.  The system call stubs
+// from rtos.asm call straight in to the host kernel instead.
+extern
+INT
+TrapEnter
+    (
+        IN UINT systemCall,
+        IN UINTPTR arg0,
+        IN UINTPTR arg1,
+        IN UINTPTR arg2,
+        IN UINTPTR arg3,
+        IN UINTPTR arg4
+    );
+
+INT
+Create
+    (
+        IN TASK_PRIORITY priority,
+        IN TASK_START_FUNC code
+    )
+{
+    return TrapEnter(0, priority, (UINTPTR) code, 0, 0, 0);
+}
+
+INT
+CreateEx
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_FUNC code
+    )
+{
+    return TrapEnter(10, priority, stackClass, (UINTPTR) code, 0, 0);
+}
+
+INT
+CreateWithArg
+    (
+        IN TASK_PRIORITY priority,
+        IN TASK_START_ARG_FUNC code,
+        IN PVOID argument,
+        IN INT argumentLength
+    )
+{
+    return TrapEnter(23, priority, (UINTPTR) code, (UINTPTR) argument, argumentLength, 0);
+}
+
+INT
+CreateExWithArg
+    (
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN TASK_START_ARG_FUNC code,
+        IN PVOID argument,
+        IN INT argumentLength
+    )
+{
+    return TrapEnter(24, priority, stackClass, (UINTPTR) code, (UINTPTR) argument, argumentLength);
+}
+
+INT
+MyTid
+    (
+        VOID
+    )
+{
+    return TrapEnter(1, 0, 0, 0, 0, 0);
+}
+
+INT
+MyParentTid
+    (
+        VOID
+    )
+{
+    return TrapEnter(2, 0, 0, 0, 0, 0);
+}
+
+VOID
+Pass
+    (
+        VOID
+    )
+{
+    TrapEnter(3, 0, 0, 0, 0, 0);
+}
+
+VOID
+Exit
+    (
+        VOID
+    )
+{
+    TrapEnter(4, 0, 0, 0, 0, 0);
+}
+
+INT
+Send
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN PVOID reply,
+        IN INT replyLength
+    )
+{
+    return TrapEnter(5, taskId, (UINTPTR) message, messageLength, (UINTPTR) reply, replyLength);
+}
+
+INT
+Receive
+    (
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength
+    )
+{
+    return TrapEnter(6, (UINTPTR) taskId, (UINTPTR) message, messageLength, 0, 0);
+}
+
+INT
+ReceiveTimeout
+    (
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    )
+{
+    return TrapEnter(15, (UINTPTR) taskId, (UINTPTR) message, messageLength, ticks, 0);
+}
+
+INT
+ReceiveUntil
+    (
+        OUT INT* taskId,
+        OUT PVOID message,
+        IN INT messageLength,
+        IN INT tick
+    )
+{
+    return TrapEnter(26, (UINTPTR) taskId, (UINTPTR) message, messageLength, tick, 0);
+}
+
+INT
+Reply
+    (
+        IN INT taskId,
+        IN PVOID reply,
+        IN INT replyLength
+    )
+{
+    return TrapEnter(7, taskId, (UINTPTR) reply, replyLength, 0, 0);
+}
+
+VOID
+EnablePriorityInheritance
+    (
+        VOID
+    )
+{
+    TrapEnter(22, 0, 0, 0, 0, 0);
+}
+
+INT
+CreateTopic
+    (
+        VOID
+    )
+{
+    return TrapEnter(17, 0, 0, 0, 0, 0);
+}
+
+INT
+Subscribe
+    (
+        IN INT topic,
+        OUT PVOID buffer,
+        IN INT bufferLength
+    )
+{
+    return TrapEnter(18, topic, (UINTPTR) buffer, bufferLength, 0, 0);
+}
+
+INT
+Publish
+    (
+        IN INT topic,
+        IN PVOID message,
+        IN INT messageLength
+    )
+{
+    return TrapEnter(19, topic, (UINTPTR) message, messageLength, 0, 0);
+}
+
+INT
+AwaitEvent
+    (
+        EVENT event
+    )
+{
+    return TrapEnter(8, event, 0, 0, 0, 0);
+}
+
+INT
+AwaitEventData
+    (
+        IN EVENT event,
+        OUT PVOID buffer,
+        IN INT bufferLength
+    )
+{
+    return TrapEnter(20, event, (UINTPTR) buffer, bufferLength, 0, 0);
+}
+
+INT
+QueryPerformance
+    (
+        IN INT taskId,
+        OUT TASK_PERFORMANCE* performance
+    )
+{
+    return TrapEnter(9, taskId, (UINTPTR) performance, 0, 0, 0);
+}
+
+INT
+QueryPerformanceAll
+    (
+        OUT TASK_PERFORMANCE* performance,
+        IN INT numTasks
+    )
+{
+    return TrapEnter(21, (UINTPTR) performance, numTasks, 0, 0, 0);
+}
+
+INT
+DumpKernelTrace
+    (
+        IN TRACE_DUMP when
+    )
+{
+    return TrapEnter(11, when, 0, 0, 0, 0);
+}
+
+INT
+ReadKernelTrace
+    (
+        OUT STRING buffer,
+        IN INT bufferLength
+    )
+{
+    return TrapEnter(25, (UINTPTR) buffer, bufferLength, 0, 0, 0);
+}
+
+INT
+QueryEventLatency
+    (
+        IN EVENT event,
+        OUT EVENT_LATENCY* latency
+    )
+{
+    return TrapEnter(12, event, (UINTPTR) latency, 0, 0, 0);
+}
+
+INT
+Post
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength
+    )
+{
+    return TrapEnter(16, taskId, (UINTPTR) message, messageLength, 0, 0);
+}
+
+INT
+DelayedSend
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT ticks
+    )
+{
+    return TrapEnter(13, taskId, (UINTPTR) message, messageLength, ticks, 0);
+}
+
+INT
+SendAt
+    (
+        IN INT taskId,
+        IN PVOID message,
+        IN INT messageLength,
+        IN INT tick
+    )
+{
+    return TrapEnter(14, taskId, (UINTPTR) message, messageLength, tick, 0);
+}
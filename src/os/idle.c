@@ -5,25 +5,22 @@
 
 static volatile BOOLEAN g_running;
 
-static
 VOID
-IdlepTask
+IdleInit
     (
         VOID
     )
 {
-    while(g_running) {  }
+    g_running = TRUE;
 }
 
 VOID
-IdleCreateTask
+IdleTask
     (
         VOID
     )
 {
-    g_running = TRUE;
-
-    VERIFY(SUCCESSFUL(Create(IdlePriority, IdlepTask)));
+    while(g_running) {  }
 }
 
 VOID
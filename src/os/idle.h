@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-IdleCreateTask
+IdleInit
+    (
+        VOID
+    );
+
+VOID
+IdleTask
     (
         VOID
     );
@@ -10,21 +10,43 @@
 #include "idle.h"
 #include "io.h"
 #include "name_server.h"
+#include "services.h"
 #include "shutdown.h"
 #include "uart.h"
 
+INT g_osServiceIds[NumOsService];
+
+static
+inline
+VOID
+InitpDeclareOsServices
+    (
+        OUT SERVICE* manifest
+    )
+{
+    // The idle task must come first, user code expects it to have task id 1
+    ServiceDeclare(&manifest[IdleService], IdleTask, IdlePriority, LargeStack, IdleInit);
+    ServiceDeclare(&manifest[NameService], NameServerTask, Priority29, LargeStack, NameServerInit);
+    ServiceDeclare(&manifest[ShutdownService], ShutdownTask, LowestSystemPriority, LargeStack, NULL);
+    ServiceDeclare(&manifest[ClockService], ClockServerTask, Priority29, LargeStack, NULL);
+    ServiceDeclare(&manifest[IoService], IoServerTask, Priority28, LargeStack, NULL);
+}
+
 VOID
 InitOsTasks
     (
         VOID
     )
 {
+    SERVICE manifest[NumOsService];
+
     // Initialize RTOS
-    IdleCreateTask();
-    NameServerCreateTask();
-    ShutdownCreateTask();
-    ClockServerCreateTask();
-    IoCreateTask();
+    InitpDeclareOsServices(manifest);
+    ServiceCreateAll(manifest, NumOsService, g_osServiceIds);
+
+    // We still outrank every service, so anything slow here holds up the
+    // whole system.  Only create tasks from here on, then exit.
+    // The uart tasks take arguments, so they still register by name.
     UartCreateTasks();
 
     VERIFY(SUCCESSFUL(Create(LowestUserPriority, InitUserTasks)));
@@ -12,22 +12,21 @@ INT
         OUT IO_DEVICE* device
     );
 
-typedef
-CHAR
-(*IO_READ_FUNC)
-    (
-        VOID
-    );
+// Device fifos hold at most this many characters
+#define IO_MAX_BATCH_SIZE 16
 
+// Writes as many characters as the device will take, up to bufferLength.
+// Returns the number of characters written.
 typedef
-VOID
+UINT
 (*IO_WRITE_FUNC)
     (
-        CHAR c
+        IN PCHAR buffer,
+        IN UINT bufferLength
     );
 
 VOID
-IoCreateTask
+IoServerTask
     (
         VOID
     );
@@ -44,7 +43,6 @@ IoCreateReadTask
     (
         IN TASK_PRIORITY priority, 
         IN EVENT event, 
-        IN IO_READ_FUNC readFunc, 
         IN STRING name
     );
 
@@ -3,14 +3,12 @@
 #include <rtosc/assert.h>
 #include <rtosc/buffer.h>
 #include <rtos.h>
-#include "courier.h"
 
 #define DEFAULT_BUFFER_SIZE 512
 
 typedef struct _IO_READ_TASK_NOTIFIER_PARAMS
 {
     EVENT event;
-    IO_READ_FUNC read;
 } IO_READ_TASK_NOTIFIER_PARAMS;
 
 typedef struct _IO_READ_TASK_PARAMS
@@ -32,7 +30,11 @@ typedef struct _IO_READ_REQUEST
 
     union 
     {
-        CHAR c;
+        struct
+        {
+            UINT length;
+            CHAR data[IO_MAX_BATCH_SIZE];
+        };
         struct
         {
             PVOID buffer;
@@ -52,34 +54,36 @@ static
 VOID
 IopReadNotifierTask
     (
-        VOID
+        IN PVOID argument
     )
 {
     IO_READ_REQUEST request = { NotifierRequest };
-    IO_READ_TASK_NOTIFIER_PARAMS params;
-    INT parentId;
-
-    // Get parameters
-    VERIFY(SUCCESSFUL(Receive(&parentId, &params, sizeof(params))));
-    VERIFY(SUCCESSFUL(Reply(parentId, NULL, 0)));
-
-    // Setup a courier
-    CourierCreateTask(Priority30, MyTid(), parentId);
+    IO_READ_TASK_NOTIFIER_PARAMS* params = argument;
+    INT parentId = MyParentTid();
 
     // Run the notifier
     while(1)
     {
-        CHAR c;
+        INT status;
 
-        // Wait for the read event to come in
-        VERIFY(SUCCESSFUL(AwaitEvent(params.event)));
+        // Collect everything the kernel has received
+        status = AwaitEventData(params->event, request.data, sizeof(request.data));
+        ASSERT(status > 0);
+
+        // Send it off to the read server.  If the server has fallen that far
+        // behind, drop the characters like the UART would have.
+        request.length = status;
+        status = Post(parentId, &request, sizeof(request));
+
+        // Running out of message buffers is the kernel's problem, not the
+        // server's.  Hold on to the characters until a buffer frees up.
+        while(POST_OUT_OF_MESSAGES == status)
+        {
+            VERIFY(SUCCESSFUL(Delay(1)));
+            status = Post(parentId, &request, sizeof(request));
+        }
 
-        // Read the new character
-        c = params.read();
-        
-        // Send it off to the read server
-        request.c = c;
-        CourierPickup(&request, sizeof(request));
+        ASSERT(SUCCESSFUL(status) || POST_QUEUE_FULL == status);
     }
 }
 
@@ -87,34 +91,25 @@ static
 VOID
 IopReadTask
     (
-        VOID
+        IN PVOID argument
     )
 {
     CHAR underlyingReceiveBuffer[DEFAULT_BUFFER_SIZE];
     RT_CIRCULAR_BUFFER receiveBuffer;
     IO_PENDING_READ underlyingPendingReadBuffer[NUM_TASKS];
     RT_CIRCULAR_BUFFER pendingReadQueue;
-    IO_READ_TASK_PARAMS params;
+    IO_READ_TASK_PARAMS* params = argument;
     INT sender;
-    INT notifierTaskId;
-
-    // Get parameters
-    VERIFY(SUCCESSFUL(Receive(&sender, &params, sizeof(params))));
-    VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
 
     // Register with the name server
-    VERIFY(SUCCESSFUL(RegisterAs(params.name)));
+    VERIFY(SUCCESSFUL(RegisterAs(params->name)));
 
     // Set up the notifier task
-    notifierTaskId = Create(HighestSystemPriority, IopReadNotifierTask);
-    ASSERT(SUCCESSFUL(notifierTaskId));
-
-    // Send the notifier task the necessary parameters
-    VERIFY(SUCCESSFUL(Send(notifierTaskId, 
-                           &params.notifierParams, 
-                           sizeof(params.notifierParams), 
-                           NULL, 
-                           0)));
+    VERIFY(SUCCESSFUL(CreateExWithArg(HighestSystemPriority,
+                                      SmallStack,
+                                      IopReadNotifierTask,
+                                      &params->notifierParams,
+                                      sizeof(params->notifierParams))));
 
     // Initialize task parameters
     RtCircularBufferInit(&receiveBuffer, 
@@ -134,16 +129,13 @@ IopReadTask
         switch(request.type)
         {
             case NotifierRequest:
-                // Reply to the notifier
-                VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
-                
-                // Add the received character to the buffer
+                // Add the received characters to the buffer
                 VERIFY(RT_SUCCESS(RtCircularBufferPush(&receiveBuffer, 
-                                                       &request.c, 
-                                                       sizeof(request.c))));
+                                                       request.data, 
+                                                       request.length)));
 
-                // Check to see if anyone is waiting on data
-                if(!RtCircularBufferIsEmpty(&pendingReadQueue))
+                // A batch of characters may satisfy several waiting tasks
+                while(!RtCircularBufferIsEmpty(&pendingReadQueue))
                 {
                     IO_PENDING_READ pendingRead;
 
@@ -167,6 +159,10 @@ IopReadTask
                         // Unblock the task
                         VERIFY(SUCCESSFUL(Reply(pendingRead.taskId, NULL, 0)));
                     }
+                    else
+                    {
+                        break;
+                    }
                 }
 
                 break;
@@ -219,29 +215,15 @@ IoCreateReadTask
     (
         IN TASK_PRIORITY priority, 
         IN EVENT event, 
-        IN IO_READ_FUNC readFunc, 
         IN STRING name
     )
 {
-    INT result = Create(priority, IopReadTask);
+    IO_READ_TASK_PARAMS params;
 
-    if(SUCCESSFUL(result))
-    {
-        INT taskId = result;
-        IO_READ_TASK_PARAMS params;
-
-        params.notifierParams.event = event;
-        params.notifierParams.read = readFunc;
-        params.name = name;
-
-        result = Send(taskId, 
-                      &params, 
-                      sizeof(params), 
-                      NULL, 
-                      0);
-    }
+    params.notifierParams.event = event;
+    params.name = name;
 
-    return result;
+    return CreateWithArg(priority, IopReadTask, &params, sizeof(params));
 }
 
 INT
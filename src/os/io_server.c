@@ -2,7 +2,7 @@
 
 #include <rtosc/assert.h>
 
-#define IO_SERVER_NAME "io"
+#include "services.h"
 
 typedef struct _IO_REGISTER_REQUEST
 {
@@ -33,17 +33,14 @@ typedef struct _IO_SERVER_REQUEST
     };
 } IO_SERVER_REQUEST;
 
-static
 VOID
-IopTask
+IoServerTask
     (
         VOID
     )
 {
     IO_OPEN_FUNC openFunctions[NumDeviceType] = { NULL };
 
-    VERIFY(SUCCESSFUL(RegisterAs(IO_SERVER_NAME)));
-
     while(1)
     {
         IO_SERVER_REQUEST request;
@@ -89,15 +86,6 @@ IopTask
     }
 }
 
-VOID
-IoCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority28, IopTask)));
-}
-
 INT
 IoRegisterDriver
     (
@@ -105,7 +93,7 @@ IoRegisterDriver
         IN IO_OPEN_FUNC openFunc
     )
 {
-    INT result = WhoIs(IO_SERVER_NAME);
+    INT result = g_osServiceIds[IoService];
 
     if(SUCCESSFUL(result))
     {
@@ -134,7 +122,7 @@ Open
         OUT IO_DEVICE* device
     )
 {
-    INT result = WhoIs(IO_SERVER_NAME);
+    INT result = g_osServiceIds[IoService];
 
     if(SUCCESSFUL(result))
     {
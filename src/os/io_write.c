@@ -34,22 +34,18 @@ static
 VOID
 IopWriteNotifierTask
     (
-        VOID
+        IN PVOID argument
     )
 {
     IO_WRITE_REQUEST request = { NotifierRequest };
-    IO_WRITE_TASK_NOTIFIER_PARAMS params;
-    INT parentId;
-
-    // Get parameters
-    VERIFY(SUCCESSFUL(Receive(&parentId, &params, sizeof(params))));
-    VERIFY(SUCCESSFUL(Reply(parentId, NULL, 0)));
+    IO_WRITE_TASK_NOTIFIER_PARAMS* params = argument;
+    INT parentId = MyParentTid();
 
     // Run the notifier
     while(1)
     {
         // Wait for the event to come in
-        VERIFY(SUCCESSFUL(AwaitEvent(params.event)));
+        VERIFY(SUCCESSFUL(AwaitEvent(params->event)));
 
         // Send it off to the write server
         VERIFY(SUCCESSFUL(Send(parentId, &request, sizeof(request), NULL, 0)));
@@ -66,13 +62,16 @@ IopPerformWrite
         IN RT_CIRCULAR_BUFFER* buffer
     )
 {
-    CHAR c;
+    CHAR characters[IO_MAX_BATCH_SIZE];
+    UINT length = min(RtCircularBufferSize(buffer), sizeof(characters));
+    UINT written;
 
-    // Grab the next character to be written
-    VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(buffer, &c, sizeof(c))));
+    // Grab as many characters as the device could take
+    VERIFY(RT_SUCCESS(RtCircularBufferPeek(buffer, characters, length)));
 
-    // Write the character
-    write(c);
+    // Write them, and only drop the ones that made it
+    written = write(characters, length);
+    VERIFY(RT_SUCCESS(RtCircularBufferPop(buffer, written)));
 
     // Unblock the notifier
     VERIFY(SUCCESSFUL(Reply(notifierTaskId, NULL, 0)));
@@ -82,34 +81,27 @@ static
 VOID
 IopWriteTask
     (
-        VOID
+        IN PVOID argument
     )
 {
     CHAR underlyingTransmitBuffer[DEFAULT_BUFFER_SIZE];
     RT_CIRCULAR_BUFFER transmitBuffer;
     BOOLEAN canWrite;
-    IO_WRITE_TASK_PARAMS params;
+    IO_WRITE_TASK_PARAMS* params = argument;
     INT sender;
     INT notifierTaskId;
 
-    // Get parameters
-    VERIFY(SUCCESSFUL(Receive(&sender, &params, sizeof(params))));
-    VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
-
     // Register with the name server
-    VERIFY(SUCCESSFUL(RegisterAs(params.name)));
+    VERIFY(SUCCESSFUL(RegisterAs(params->name)));
 
     // Set up the notifier task
-    notifierTaskId = Create(HighestSystemPriority, IopWriteNotifierTask);
+    notifierTaskId = CreateExWithArg(HighestSystemPriority,
+                                     SmallStack,
+                                     IopWriteNotifierTask,
+                                     &params->notifierParams,
+                                     sizeof(params->notifierParams));
     ASSERT(SUCCESSFUL(notifierTaskId));
 
-    // Send the notifier task the necessary parameters
-    VERIFY(SUCCESSFUL(Send(notifierTaskId, 
-                           &params.notifierParams, 
-                           sizeof(params.notifierParams), 
-                           NULL, 
-                           0)));
-
     // Initialize task variables
     canWrite = FALSE;
     RtCircularBufferInit(&transmitBuffer, 
@@ -132,7 +124,7 @@ IopWriteTask
                 }
                 else
                 {
-                    IopPerformWrite(notifierTaskId, params.write, &transmitBuffer);
+                    IopPerformWrite(notifierTaskId, params->write, &transmitBuffer);
                 }
                 
                 break;
@@ -145,7 +137,7 @@ IopWriteTask
                 if(canWrite)
                 {
                     canWrite = FALSE;
-                    IopPerformWrite(notifierTaskId, params.write, &transmitBuffer);
+                    IopPerformWrite(notifierTaskId, params->write, &transmitBuffer);
                 }
 
                 VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
@@ -167,25 +159,13 @@ IoCreateWriteTask
         IN STRING name
     )
 {
-    INT result = Create(priority, IopWriteTask);
+    IO_WRITE_TASK_PARAMS params;
 
-    if(SUCCESSFUL(result))
-    {
-        INT taskId = result;
-        IO_WRITE_TASK_PARAMS params;
-
-        params.notifierParams.event = event;
-        params.write = writeFunc;
-        params.name = name;
-
-        result = Send(taskId, 
-                      &params, 
-                      sizeof(params), 
-                      NULL, 
-                      0);
-    }
+    params.notifierParams.event = event;
+    params.write = writeFunc;
+    params.name = name;
 
-    return result;
+    return CreateWithArg(priority, IopWriteTask, &params, sizeof(params));
 }
 
 INT
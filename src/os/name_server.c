@@ -4,6 +4,8 @@
 #include <rtosc/assert.h>
 #include <rtosc/string.h>
 
+#include "services.h"
+
 #define NAME_SERVER_HASH_TABLE_SIZE (NUM_TASKS * 2)
 
 #define ERROR_SUCCESS 0
@@ -12,8 +14,7 @@
 
 typedef enum _NAME_SERVER_REQUEST_TYPE
 {
-    RegisterRequest = 0,
-    WhoIsRequest
+    RegisterRequest = 0
 } NAME_SERVER_REQUEST_TYPE;
 
 typedef struct _NAME_SERVER_REQUEST
@@ -22,13 +23,16 @@ typedef struct _NAME_SERVER_REQUEST
     STRING name;
 } NAME_SERVER_REQUEST;
 
+// Only the name server writes entries, but any task may read them.
+// Volatile keeps a new entry's value written before its key.
 typedef struct _NAME_SERVER_ENTRY
 {
-    STRING key;
-    INT value;
+    STRING volatile key;
+    volatile INT value;
 } NAME_SERVER_ENTRY;
 
-static INT g_nameServerId;
+// WhoIs() looks names up here directly instead of asking the name server
+static NAME_SERVER_ENTRY g_hashTable[NAME_SERVER_HASH_TABLE_SIZE];
 
 static
 inline
@@ -90,10 +94,12 @@ NameServerpInsert
         UINT index = (hash + i) % NAME_SERVER_HASH_TABLE_SIZE;
         NAME_SERVER_ENTRY* entry = &hashTable[index];
 
-        if(entry->key == "" || RtStrEqual(key, entry->key))
+        if('\0' == *entry->key || RtStrEqual(key, entry->key))
         {
-            entry->key = key;
+            // A task looking the name up may see the key as soon as it
+            // is written, so the value has to be there first
             entry->value = value;
+            entry->key = key;
 
             return TRUE;
         }
@@ -120,6 +126,12 @@ NameServerpFind
         UINT index = (hash + i) % NAME_SERVER_HASH_TABLE_SIZE;
         NAME_SERVER_ENTRY* entry = &hashTable[index];
 
+        // Names are never removed, so the name would have been put here
+        if('\0' == *entry->key)
+        {
+            break;
+        }
+
         if(RtStrEqual(key, entry->key))
         {
             *value = entry->value;
@@ -130,17 +142,13 @@ NameServerpFind
 
     return FALSE;
 }
-#include <bwio/bwio.h>
+
 VOID
-NameServerpTask
+NameServerTask
     (
         VOID
     )
 {
-    NAME_SERVER_ENTRY hashTable[NAME_SERVER_HASH_TABLE_SIZE];
-
-    NameServerpInitializeHashTable(hashTable);
-
     while(1)
     {
         NAME_SERVER_REQUEST request;
@@ -153,25 +161,13 @@ NameServerpTask
         switch(request.type)
         {
             case RegisterRequest:
-                success = NameServerpInsert(hashTable,
+                success = NameServerpInsert(g_hashTable,
                                             request.name,
                                             senderTaskId);
 
                 response = success ? ERROR_SUCCESS : ERROR_NAME_SERVER_FULL;
                 break;
 
-            case WhoIsRequest:
-                success = NameServerpFind(hashTable,
-                                          request.name,
-                                          &response);
-                
-                if(!success)
-                {
-                    response = ERROR_NAME_SERVER_NOT_FOUND;
-                }
-
-                break;
-
             default:
                 ASSERT(FALSE);
                 break;
@@ -182,13 +178,12 @@ NameServerpTask
 }
 
 VOID
-NameServerCreateTask
+NameServerInit
     (
         VOID
     )
 {
-    g_nameServerId = Create(Priority29, NameServerpTask);
-    ASSERT(SUCCESSFUL(g_nameServerId));
+    NameServerpInitializeHashTable(g_hashTable);
 }
 
 static
@@ -203,7 +198,7 @@ SendNameServerRequest
     NAME_SERVER_REQUEST request = { type,  name };
     INT response;
 
-    VERIFY(SUCCESSFUL(Send(g_nameServerId,
+    VERIFY(SUCCESSFUL(Send(g_osServiceIds[NameService],
                            &request,
                            sizeof(request),
                            &response,
@@ -227,5 +222,14 @@ WhoIs
         IN STRING name
     )
 {
-    return SendNameServerRequest(WhoIsRequest, name);
+    INT taskId;
+
+    // Registering is rare, but looking up names happens on almost every
+    // API call.  Read the table without a round trip to the name server.
+    if(!NameServerpFind(g_hashTable, name, &taskId))
+    {
+        taskId = ERROR_NAME_SERVER_NOT_FOUND;
+    }
+
+    return taskId;
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-NameServerCreateTask
+NameServerInit
+    (
+        VOID
+    );
+
+VOID
+NameServerTask
     (
         VOID
     );
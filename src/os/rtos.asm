@@ -50,3 +50,88 @@ AwaitEvent:
 QueryPerformance:
     swi 9
     bx lr
+
+.globl CreateEx
+CreateEx:
+    swi 10
+    bx lr
+
+.globl DumpKernelTrace
+DumpKernelTrace:
+    swi 11
+    bx lr
+
+.globl QueryEventLatency
+QueryEventLatency:
+    swi 12
+    bx lr
+
+.globl DelayedSend
+DelayedSend:
+    swi 13
+    bx lr
+
+.globl SendAt
+SendAt:
+    swi 14
+    bx lr
+
+.globl ReceiveTimeout
+ReceiveTimeout:
+    swi 15
+    bx lr
+
+.globl Post
+Post:
+    swi 16
+    bx lr
+
+.globl CreateTopic
+CreateTopic:
+    swi 17
+    bx lr
+
+.globl Subscribe
+Subscribe:
+    swi 18
+    bx lr
+
+.globl Publish
+Publish:
+    swi 19
+    bx lr
+
+.globl AwaitEventData
+AwaitEventData:
+    swi 20
+    bx lr
+
+.globl QueryPerformanceAll
+QueryPerformanceAll:
+    swi 21
+    bx lr
+
+.globl EnablePriorityInheritance
+EnablePriorityInheritance:
+    swi 22
+    bx lr
+
+.globl CreateWithArg
+CreateWithArg:
+    swi 23
+    bx lr
+
+.globl CreateExWithArg
+CreateExWithArg:
+    swi 24
+    bx lr
+
+.globl ReadKernelTrace
+ReadKernelTrace:
+    swi 25
+    bx lr
+
+.globl ReceiveUntil
+ReceiveUntil:
+    swi 26
+    bx lr
@@ -0,0 +1,44 @@
+#include <rtos.h>
+#include <rtkernel.h>
+
+#include <rtosc/assert.h>
+
+VOID
+ServiceDeclare
+    (
+        OUT SERVICE* service,
+        IN TASK_START_FUNC startFunc,
+        IN TASK_PRIORITY priority,
+        IN STACK_CLASS stackClass,
+        IN SERVICE_INIT_FUNC init
+    )
+{
+    service->startFunc = startFunc;
+    service->priority = priority;
+    service->stackClass = stackClass;
+    service->init = init;
+}
+
+VOID
+ServiceCreateAll
+    (
+        IN SERVICE* manifest,
+        IN UINT numServices,
+        OUT INT* taskIds
+    )
+{
+    UINT i;
+
+    for(i = 0; i < numServices; i++)
+    {
+        SERVICE* service = &manifest[i];
+
+        if(NULL != service->init)
+        {
+            service->init();
+        }
+
+        taskIds[i] = CreateEx(service->priority, service->stackClass, service->startFunc);
+        ASSERT(SUCCESSFUL(taskIds[i]));
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <rt.h>
+
+// Tasks created by InitOsTasks.  Clients index
+// g_osServiceIds instead of asking the name server.
+typedef enum _OS_SERVICE
+{
+    IdleService = 0, 
+    NameService, 
+    ShutdownService, 
+    ClockService, 
+    IoService, 
+    NumOsService
+} OS_SERVICE;
+
+extern INT g_osServiceIds[NumOsService];
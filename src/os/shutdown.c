@@ -4,8 +4,7 @@
 #include <rtkernel.h>
 #include <rtos.h>
 #include "idle.h"
-
-#define SHUTDOWN_TASK_NAME "shutdown"
+#include "services.h"
 
 typedef enum _SHUTDOWN_REQUEST_TYPE
 {
@@ -19,9 +18,8 @@ typedef struct _SHUTDOWN_REQUEST
     SHUTDOWN_HOOK_FUNC shutdownHook;
 } SHUTDOWN_REQUEST;
 
-static
 VOID
-ShutdownpTask
+ShutdownTask
     (
         VOID
     )
@@ -34,8 +32,6 @@ ShutdownpTask
     {
         shutdownHooks[i] = NULL;
     }
-    
-    VERIFY(SUCCESSFUL(RegisterAs(SHUTDOWN_TASK_NAME)));
 
     while(running)
     {
@@ -88,7 +84,7 @@ ShutdownpSendRequest
         IN SHUTDOWN_REQUEST* request
     )
 {
-    INT result = WhoIs(SHUTDOWN_TASK_NAME);
+    INT result = g_osServiceIds[ShutdownService];
 
     if(SUCCESSFUL(result))
     {
@@ -125,12 +121,3 @@ Shutdown
 
     VERIFY(SUCCESSFUL(ShutdownpSendRequest(&request)));
 }
-
-VOID
-ShutdownCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(LowestSystemPriority, ShutdownpTask)));
-}
@@ -10,7 +10,7 @@
 #define UART_COM2_READ_NAME "com2_r"
 #define UART_COM2_WRITE_NAME "com2_w"
 
-#define UART_DATA(uartBase) ((volatile UINT*) (uartBase + UART_DATA_OFFSET))
+#define UART_FLAG(uartBase) ((volatile UINT*) (uartBase + UART_FLAG_OFFSET))
 
 static
 INT
@@ -48,43 +48,46 @@ UartpOpen
 }
 
 static
-CHAR
-UartpCom1Read
+inline
+UINT
+UartpWrite
     (
-        VOID
+        IN UINTPTR uartBase,
+        IN PCHAR buffer,
+        IN UINT bufferLength
     )
 {
-    return *UART_DATA(UART1_BASE);
-}
+    UINT i = 0;
 
-static
-VOID
-UartpCom1Write
-    (
-        CHAR c
-    )
-{
-    *UART_DATA(UART1_BASE) = c;
+    while(i < bufferLength && !(*UART_FLAG(uartBase) & TXFF_MASK))
+    {
+        UART_WRITE_DATA(uartBase, buffer[i++]);
+    }
+
+    return i;
 }
 
 static
-CHAR
-UartpCom2Read
+UINT
+UartpCom1Write
     (
-        VOID
+        IN PCHAR buffer,
+        IN UINT bufferLength
     )
 {
-    return *UART_DATA(UART2_BASE);
+    // The train controller has to raise clear to send between bytes
+    return UartpWrite(UART1_BASE, buffer, min(bufferLength, 1));
 }
 
 static
-VOID
+UINT
 UartpCom2Write
     (
-        CHAR c
+        IN PCHAR buffer,
+        IN UINT bufferLength
     )
 {
-    *UART_DATA(UART2_BASE) = c;
+    return UartpWrite(UART2_BASE, buffer, bufferLength);
 }
 
 VOID
@@ -99,7 +102,6 @@ UartCreateTasks
     // Create the uart I/O servers
     VERIFY(SUCCESSFUL(IoCreateReadTask(Priority29, 
                                        UartCom1ReceiveEvent, 
-                                       UartpCom1Read, 
                                        UART_COM1_READ_NAME)));
     VERIFY(SUCCESSFUL(IoCreateWriteTask(Priority29, 
                                         UartCom1TransmitEvent, 
@@ -107,7 +109,6 @@ UartCreateTasks
                                         UART_COM1_WRITE_NAME)));
     VERIFY(SUCCESSFUL(IoCreateReadTask(Priority11, 
                                        UartCom2ReceiveEvent, 
-                                       UartpCom2Read, 
                                        UART_COM2_READ_NAME)));
     VERIFY(SUCCESSFUL(IoCreateWriteTask(Priority11, 
                                         UartCom2TransmitEvent, 
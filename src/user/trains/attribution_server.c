@@ -1,6 +1,7 @@
 #include "attribution_server.h"
 
 #include "display.h"
+#include "services.h"
 #include <rtosc/assert.h>
 #include <rtosc/buffer.h>
 #include <rtosc/string.h>
@@ -8,15 +9,12 @@
 #include <rtos.h>
 #include <user/trains.h>
 
-#define ATTRIBUTION_SERVER_NAME "attribution"
-
 typedef enum _ATTRIBUTION_SERVER_REQUEST_TYPE
 {
     SensorChangedRequest = 0,
     SpeedChangedRequest,
     DirectionChangedRequest,
     SwitchChangedRequest,
-    AttributedSensorAwaitRequest,
     GetTrackedTrainsRequest,
     NextExpectedNodeRequest
 } ATTRIBUTION_SERVER_REQUEST_TYPE;
@@ -42,6 +40,8 @@ typedef struct _ATTRIBUTION_DATA
     TRACK_NODE* nextNode;
 } ATTRIBUTION_DATA;
 
+static INT g_attributedSensorTopic;
+
 static
 VOID
 AttributionServerpSensorNotifierTask
@@ -182,17 +182,12 @@ AttributionServerpFindTrainById
     return NULL;
 }
 
-static
 VOID
-AttributionServerpTask
+AttributionServerTask
     (
         VOID
     )
 {
-    INT underlyingAwaitingTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingTasks;
-    RtCircularBufferInit(&awaitingTasks, underlyingAwaitingTasksBuffer, sizeof(underlyingAwaitingTasksBuffer));
-    
     UCHAR underlyingLostTrainsBuffer[MAX_TRACKABLE_TRAINS];
     RT_CIRCULAR_BUFFER lostTrains;
     RtCircularBufferInit(&lostTrains, underlyingLostTrainsBuffer, sizeof(underlyingLostTrainsBuffer));
@@ -201,11 +196,11 @@ AttributionServerpTask
     ATTRIBUTION_DATA trackedTrains[MAX_TRACKABLE_TRAINS];
     RtMemset(trackedTrains, sizeof(trackedTrains), 0);
 
-    VERIFY(SUCCESSFUL(RegisterAs(ATTRIBUTION_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, AttributionServerpSensorNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, AttributionServerpSpeedNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, AttributionServerpDirectionNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, AttributionServerpSwitchNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, AttributionServerpSensorNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, AttributionServerpSpeedNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, AttributionServerpDirectionNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, AttributionServerpSwitchNotifierTask)));
 
     while(1)
     {
@@ -249,7 +244,7 @@ AttributionServerpTask
                         Log("Attribution server unable to find sensor after %s", sensorNode->name);
                     }
 
-                    // Let any awaiting tasks know about the sensor
+                    // Let any subscribers know about the sensor
                     INT currentTime = Time();
                     ASSERT(SUCCESSFUL(currentTime));
 
@@ -258,12 +253,7 @@ AttributionServerpTask
                     attributedSensor.timeTripped = currentTime - AVERAGE_SENSOR_LATENCY;
                     attributedSensor.sensor = request.sensor;
 
-                    INT awaitingTask;
-                    while(!RtCircularBufferIsEmpty(&awaitingTasks))
-                    {
-                        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(&awaitingTasks, &awaitingTask, sizeof(awaitingTask))));
-                        VERIFY(SUCCESSFUL(Reply(awaitingTask, &attributedSensor, sizeof(attributedSensor))));
-                    }
+                    VERIFY(SUCCESSFUL(Publish(g_attributedSensorTopic, &attributedSensor, sizeof(attributedSensor))));
                 }
                 else
                 {
@@ -345,12 +335,6 @@ AttributionServerpTask
                 break;
             }
 
-            case AttributedSensorAwaitRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingTasks, &senderId, sizeof(senderId))));
-                break;
-            }
-
             case GetTrackedTrainsRequest:
             {
                 TRACKED_TRAINS trains;
@@ -391,12 +375,13 @@ AttributionServerpTask
 }
 
 VOID
-AttributionServerCreate
+AttributionServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority22, AttributionServerpTask)));
+    g_attributedSensorTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_attributedSensorTopic));
 }
 
 INT
@@ -405,7 +390,7 @@ AttributionServerGetTrackedTrains
         OUT TRACKED_TRAINS* trackedTrains
     )
 {
-    INT result = WhoIs(ATTRIBUTION_SERVER_NAME);
+    INT result = g_trainServiceIds[AttributionService];
 
     if(SUCCESSFUL(result))
     {
@@ -427,7 +412,7 @@ AttributionServerNextExpectedNode
         OUT TRACK_NODE** nextExpectedNode
     )
 {
-    INT result = WhoIs(ATTRIBUTION_SERVER_NAME);
+    INT result = g_trainServiceIds[AttributionService];
 
     if(SUCCESSFUL(result))
     {
@@ -449,17 +434,5 @@ AttributedSensorAwait
         OUT ATTRIBUTED_SENSOR* attributedSensor
     )
 {
-    INT result = WhoIs(ATTRIBUTION_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT attributionServerId = result;
-
-        ATTRIBUTION_SERVER_REQUEST request;
-        request.type = AttributedSensorAwaitRequest;
-
-        result = Send(attributionServerId, &request, sizeof(request), attributedSensor, sizeof(*attributedSensor));
-    }
-
-    return result;
+    return Subscribe(g_attributedSensorTopic, attributedSensor, sizeof(*attributedSensor));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-AttributionServerCreate
+AttributionServerInit
+    (
+        VOID
+    );
+
+VOID
+AttributionServerTask
     (
         VOID
     );
@@ -7,7 +7,7 @@
 #include "display.h"
 
 VOID
-ClockpTask
+ClockTask
     (
         VOID
     )
@@ -21,12 +21,3 @@ ClockpTask
         Delay(10);
     }
 }
-
-VOID
-ClockCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(LowestUserPriority, ClockpTask)));
-}
@@ -111,9 +111,8 @@ ConductorpIsReversing
     return data->reverseCount > 0;
 }
 
-static
 VOID
-ConductorpTask
+ConductorTask
     (
         VOID
     )
@@ -121,9 +120,10 @@ ConductorpTask
     CONDUCTOR_DATA trainData[MAX_TRAINS];
     RtMemset(trainData, sizeof(trainData), 0);
 
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, ConductorpRouteNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, ConductorpSpeedChangeNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, ConductorpDirectionChangeNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, ConductorpRouteNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, ConductorpSpeedChangeNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, ConductorpDirectionChangeNotifierTask)));
 
     while(1)
     {
@@ -227,12 +227,3 @@ ConductorpTask
         }
     }
 }
-
-VOID
-ConductorCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority18, ConductorpTask)));
-}
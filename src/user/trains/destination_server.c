@@ -1,6 +1,7 @@
 #include "destination_server.h"
 
 #include "display.h"
+#include "services.h"
 #include <rtosc/assert.h>
 #include <rtosc/rand.h>
 #include <rtosc/string.h>
@@ -8,7 +9,6 @@
 #include <rtos.h>
 #include <user/trains.h>
 
-#define DESTINATION_SERVER_NAME "dest"
 #define DESTINATION_SERVER_LOOKING_FOR_TRAIN_SPEED 10
 
 typedef enum _DESTINATION_REQUEST_TYPE
@@ -159,9 +159,8 @@ DestinationServerpRouteToDestination
     Log("Driving train %d to %s", train, location->node->name);
 }
 
-static
 VOID
-DestinationServerpTask
+DestinationServerTask
     (
         VOID
     )
@@ -169,9 +168,9 @@ DestinationServerpTask
     DESTINATION_DATA destinations[MAX_TRAINS];
     RtMemset(destinations, sizeof(destinations), 0);
 
-    VERIFY(SUCCESSFUL(RegisterAs(DESTINATION_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, DestinationServerpAttributedSensorNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, DestinationServerpDestinationReachedNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, DestinationServerpAttributedSensorNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, DestinationServerpDestinationReachedNotifierTask)));
 
     while(1)
     {
@@ -279,15 +278,6 @@ DestinationServerpTask
     }
 }
 
-VOID
-DestinationServerCreate
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority15, DestinationServerpTask)));
-}
-
 INT
 TrainDestinationOnce
     (
@@ -295,7 +285,7 @@ TrainDestinationOnce
         IN LOCATION* location
     )
 {
-    INT result = WhoIs(DESTINATION_SERVER_NAME);
+    INT result = g_trainServiceIds[DestinationService];
 
     if(SUCCESSFUL(result))
     {
@@ -317,7 +307,7 @@ TrainDestinationForever
         IN UCHAR train
     )
 {
-    INT result = WhoIs(DESTINATION_SERVER_NAME);
+    INT result = g_trainServiceIds[DestinationService];
 
     if(SUCCESSFUL(result))
     {
@@ -9,6 +9,8 @@
 
 #include <bwio/bwio.h>
 
+#include "services.h"
+
 #include <user/trains.h>
 
 #define CURSOR_MOVE         "\033[%d;%dH"
@@ -25,8 +27,6 @@
 #define CURSOR_CYAN     "\033[36m"
 #define CURSOR_WHITE    "\033[37m"
 
-#define DISPLAY_NAME "display"
-
 typedef enum _DISPLAY_REQUEST_TYPE
 {
     DisplayCharRequest = 0,
@@ -329,7 +329,7 @@ DisplaypSendRequest
         IN DISPLAY_REQUEST* request
     )
 {
-    INT result = WhoIs(DISPLAY_NAME);
+    INT result = g_trainServiceIds[DisplayService];
 
     if(SUCCESSFUL(result))
     {
@@ -353,14 +353,12 @@ DisplaypShutdownHook
     DisplaypSendRequest(&request);
 }
 
-static
 VOID
-DisplaypTask
+DisplayTask
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(RegisterAs(DISPLAY_NAME)));
     VERIFY(SUCCESSFUL(ShutdownRegisterHook(DisplaypShutdownHook)));
 
     IO_DEVICE com2Device;
@@ -442,15 +440,6 @@ DisplaypTask
     }
 }
 
-VOID
-DisplayCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority10, DisplaypTask)));
-}
-
 VOID
 ShowKeyboardChar
     (
@@ -4,7 +4,7 @@
 #include <user/trains.h>
 
 VOID
-DisplayCreateTask
+DisplayTask
     (
         VOID
     );
@@ -16,38 +16,57 @@
 #include "safety.h"
 #include "scheduler.h"
 #include "sensor_server.h"
+#include "services.h"
 #include "stop_server.h"
 #include "switch_server.h"
 #include "train_server.h"
 
+INT g_trainServiceIds[NumTrainService];
+
+static
+inline
+VOID
+InitpDeclareTrainServices
+    (
+        OUT SERVICE* manifest
+    )
+{
+    // Display
+    ServiceDeclare(&manifest[DisplayService], DisplayTask, Priority10, SmallStack, NULL);
+    ServiceDeclare(&manifest[ClockDisplayService], ClockTask, LowestUserPriority, SmallStack, NULL);
+    ServiceDeclare(&manifest[PerformanceDisplayService], PerformanceTask, LowestUserPriority, SmallStack, NULL);
+    ServiceDeclare(&manifest[InputParserService], InputParserTask, Priority9, LargeStack, NULL);
+
+    // Track
+    ServiceDeclare(&manifest[SensorService], SensorServerTask, Priority25, LargeStack, SensorServerInit);
+    ServiceDeclare(&manifest[TrainService], TrainServerTask, Priority24, LargeStack, TrainServerInit);
+    ServiceDeclare(&manifest[SwitchService], SwitchServerTask, Priority23, LargeStack, SwitchServerInit);
+    ServiceDeclare(&manifest[AttributionService], AttributionServerTask, Priority22, LargeStack, AttributionServerInit);
+    ServiceDeclare(&manifest[LocationService], LocationServerTask, Priority21, LargeStack, LocationServerInit);
+    ServiceDeclare(&manifest[RouteService], RouteServerTask, Priority20, LargeStack, RouteServerInit);
+    ServiceDeclare(&manifest[StopService], StopServerTask, Priority19, LargeStack, StopServerInit);
+    ServiceDeclare(&manifest[ConductorService], ConductorTask, Priority18, LargeStack, NULL);
+    ServiceDeclare(&manifest[SafetyService], SafetyTask, Priority17, LargeStack, NULL);
+    ServiceDeclare(&manifest[SchedulerService], SchedulerTask, Priority16, LargeStack, NULL);
+    ServiceDeclare(&manifest[DestinationService], DestinationServerTask, Priority15, LargeStack, NULL);
+}
+
 VOID
 InitTrainTasks
     (
         VOID
     )
 {
+    SERVICE manifest[NumTrainService];
+
     // Initialize libraries
     PhysicsInit();
     TrackInit(TrackA);
 
-    // Setup the display
-    DisplayCreateTask();
-    ClockCreateTask();
-    PerformanceCreateTask();
-    InputParserCreateTask();
-
-    // Setup the track
-    SensorServerCreateTask();
-    TrainServerCreate();
-    SwitchServerCreate();
-    AttributionServerCreate();
-    LocationServerCreateTask();
-    RouteServerCreate();
-    StopServerCreate();
-    ConductorCreateTask();
-    SafetyCreateTask();
-    SchedulerCreateTask();
-    DestinationServerCreate();
+    // Nothing runs until every task id has been published, and
+    // then only once we exit, since our priority is never lowered
+    InitpDeclareTrainServices(manifest);
+    ServiceCreateAll(manifest, NumTrainService, g_trainServiceIds);
 
     //CalibrationCreateTask();
 }
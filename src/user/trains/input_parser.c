@@ -8,6 +8,54 @@
 #include <rtosc/string.h>
 #include <user/trains.h>
 
+#define INPUT_PARSER_TRACE_CHUNK_LENGTH 256
+
+// COM2 sends about 460 characters every 4 ticks.  Writing a chunk at
+// most that often leaves the display room in the write server's buffer.
+#define INPUT_PARSER_TRACE_CHUNK_TICKS 4
+
+static INT g_traceTaskId;
+
+// Writes one dump at a time.  The parser posts it an empty
+// message for every trace command.
+static
+VOID
+InputParserpTraceTask
+    (
+        VOID
+    )
+{
+    CHAR buffer[INPUT_PARSER_TRACE_CHUNK_LENGTH];
+    IO_DEVICE com2Device;
+
+    VERIFY(SUCCESSFUL(Open(UartDevice, ChannelCom2, &com2Device)));
+
+    while(1)
+    {
+        INT senderId;
+        INT length;
+
+        VERIFY(SUCCESSFUL(Receive(&senderId, NULL, 0)));
+
+        // Trickle the dump out in the background instead of stopping the world
+        VERIFY(SUCCESSFUL(DumpKernelTrace(TraceDumpNow)));
+
+        while((length = ReadKernelTrace(buffer, sizeof(buffer))) > 0)
+        {
+            INT nextChunk;
+
+            VERIFY(SUCCESSFUL(Write(&com2Device, buffer, length)));
+            nextChunk = Time() + INPUT_PARSER_TRACE_CHUNK_TICKS;
+
+            // A second snapshot would restart this one half way through
+            while(RECEIVE_TIMED_OUT != ReceiveUntil(&senderId, NULL, 0, nextChunk))
+            {
+                Log("Already writing a trace dump");
+            }
+        }
+    }
+}
+
 static
 BOOLEAN
 InputParserpGetSwitchDirection
@@ -134,6 +182,17 @@ InputParserpParseCommand
             }
         }
     }
+    else if (RtStrEqual(token, "trace"))
+    {
+        if (RtStrIsWhitespace(buffer))
+        {
+            INT status = Post(g_traceTaskId, NULL, 0);
+
+            // A full queue means plenty of dumps are already on the way
+            ASSERT(SUCCESSFUL(status) || POST_QUEUE_FULL == status || POST_OUT_OF_MESSAGES == status);
+            UNREFERENCED_PARAMETER(status);
+        }
+    }
     else if (RtStrEqual(token, "q"))
     {
         if (RtStrIsWhitespace(buffer))
@@ -143,9 +202,8 @@ InputParserpParseCommand
     }
 }
 
-static
 VOID
-InputParserpTask
+InputParserTask
     (
         VOID
     )
@@ -153,6 +211,9 @@ InputParserpTask
     IO_DEVICE com2Device;
     VERIFY(SUCCESSFUL(Open(UartDevice, ChannelCom2, &com2Device)));
 
+    g_traceTaskId = CreateEx(LowestUserPriority, SmallStack, InputParserpTraceTask);
+    ASSERT(SUCCESSFUL(g_traceTaskId));
+
     CHAR buffer[256];
 
     INT i;
@@ -192,12 +253,3 @@ InputParserpTask
         InputParserpParseCommand(buffer, i);
     }
 }
-
-VOID
-InputParserCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority9, InputParserpTask)));
-}
@@ -2,18 +2,15 @@
 
 #include "display.h"
 #include "physics.h"
+#include "services.h"
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtosc/string.h>
 #include <rtkernel.h>
 #include <rtos.h>
 #include <track/track_node.h>
 #include <user/trains.h>
 
-#define LOCATION_SERVER_NAME "location"
-#define LOCATION_SERVER_REGISTRAR_NAME "location_registrar"
-
-#define LOCATION_SERVER_NOTIFIER_UPDATE_INTERVAL 3 // 30 ms
+#define LOCATION_SERVER_UPDATE_INTERVAL 3 // 30 ms
 #define LOCATION_SERVER_ALPHA 5
 
 typedef enum _LOCATION_SERVER_REQUEST_TYPE
@@ -58,37 +55,7 @@ typedef struct _TRAIN_DATA
     INT lastTimeLocationUpdated;
 } TRAIN_DATA;
 
-typedef enum _LOCATION_SERVER_REGISTRAR_REQUEST_TYPE
-{
-    LocationAwaitRequest = 0, 
-    LocationUpdateRequest
-} LOCATION_SERVER_REGISTRAR_REQUEST_TYPE;
-
-typedef struct _LOCATION_SERVER_REGISTRAR_REQUEST
-{
-    LOCATION_SERVER_REGISTRAR_REQUEST_TYPE type;
-    TRAIN_LOCATION trainLocation;
-} LOCATION_SERVER_REGISTRAR_REQUEST;
-
-static
-VOID
-LocationServerpVelocityNotifierTask
-    (
-        VOID
-    )
-{
-    INT locationServerId = MyParentTid();
-    ASSERT(SUCCESSFUL(locationServerId));
-
-    LOCATION_SERVER_REQUEST request;
-    request.type = VelocityUpdateRequest;
-
-    while(1)
-    {
-        VERIFY(SUCCESSFUL(Delay(LOCATION_SERVER_NOTIFIER_UPDATE_INTERVAL)));
-        VERIFY(SUCCESSFUL(Send(locationServerId, &request, sizeof(request), NULL, 0)));
-    }
-}
+static INT g_locationTopic;
 
 static
 VOID
@@ -106,7 +73,7 @@ LocationServerpAttributedSensorNotifierTask
     while(1)
     {
         VERIFY(SUCCESSFUL(AttributedSensorAwait(&request.attributedSensor)));
-        VERIFY(SUCCESSFUL(Send(locationServerId, &request, sizeof(request), NULL, 0)));
+        VERIFY(SUCCESSFUL(PostRetry(locationServerId, &request, sizeof(request))));
     }
 }
 
@@ -126,7 +93,7 @@ LocationServerpSpeedChangeNotifierTask
     while(1)
     {
         VERIFY(SUCCESSFUL(TrainSpeedChangeAwait(&request.trainSpeed)));
-        VERIFY(SUCCESSFUL(Send(locationServerId, &request, sizeof(request), NULL, 0)));
+        VERIFY(SUCCESSFUL(PostRetry(locationServerId, &request, sizeof(request))));
     }
 }
 
@@ -146,78 +113,7 @@ LocationServerpDirectionChangeNotifierTask
     while(1)
     {
         VERIFY(SUCCESSFUL(TrainDirectionChangeAwait(&request.trainDirection)));
-        VERIFY(SUCCESSFUL(Send(locationServerId, &request, sizeof(request), NULL, 0)));
-    }
-}
-
-static
-VOID
-LocationServerpRegistrarTask
-    (
-        VOID
-    )
-{
-    INT underlyingAwaitingTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingTasks;
-    RtCircularBufferInit(&awaitingTasks, underlyingAwaitingTasksBuffer, sizeof(underlyingAwaitingTasksBuffer));
-
-    VERIFY(SUCCESSFUL(RegisterAs(LOCATION_SERVER_REGISTRAR_NAME)));
-
-    while(1)
-    {
-        INT senderId;
-        LOCATION_SERVER_REGISTRAR_REQUEST request;
-
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-
-        switch(request.type)
-        {
-            case LocationAwaitRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingTasks, &senderId, sizeof(senderId))));
-                break;
-            }
-
-            case LocationUpdateRequest:
-            {
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
-                INT awaitingTask;
-                while(!RtCircularBufferIsEmpty(&awaitingTasks))
-                {
-                    VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(&awaitingTasks, &awaitingTask, sizeof(awaitingTask))));
-                    VERIFY(SUCCESSFUL(Reply(awaitingTask, &request.trainLocation, sizeof(request.trainLocation))));
-                }
-                break;
-            }
-
-            default:
-            {
-                ASSERT(FALSE);
-                break;
-            }
-        }
-    }
-}
-
-static
-VOID
-LocationServerpCourier
-    (
-        VOID
-    )
-{
-    INT locationServerRegistrarId = WhoIs(LOCATION_SERVER_REGISTRAR_NAME);
-    ASSERT(SUCCESSFUL(locationServerRegistrarId));
-
-    while(1)
-    {
-        INT senderId;
-        LOCATION_SERVER_REGISTRAR_REQUEST request;
-
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-        VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-        VERIFY(SUCCESSFUL(Send(locationServerRegistrarId, &request, sizeof(request), NULL, 0)));
+        VERIFY(SUCCESSFUL(PostRetry(locationServerId, &request, sizeof(request))));
     }
 }
 
@@ -308,28 +204,18 @@ LocationServerpHasBeenFound
     return NULL != trainData->location.node;
 }
 
-static
 VOID
-LocationServerpTask
+LocationServerTask
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(RegisterAs(LOCATION_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(Priority22, LocationServerpVelocityNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, LocationServerpAttributedSensorNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, LocationServerpSpeedChangeNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, LocationServerpDirectionChangeNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(Priority13, LocationServerpRegistrarTask)));
-
-    UINT nextCourierTask = 0;
-    INT courierTasks[MAX_TRACKABLE_TRAINS];
-    for(UINT i = 0; i < MAX_TRACKABLE_TRAINS; i++)
-    {
-        courierTasks[i] = Create(Priority12, LocationServerpCourier);
-        ASSERT(SUCCESSFUL(courierTasks[i]));
-    }
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, LocationServerpAttributedSensorNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, LocationServerpSpeedChangeNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, LocationServerpDirectionChangeNotifierTask)));
 
+    INT nextVelocityUpdate = Time() + LOCATION_SERVER_UPDATE_INTERVAL;
 
     UINT numTrackedTrains = 0;
     TRAIN_DATA trackedTrains[MAX_TRACKABLE_TRAINS];
@@ -340,22 +226,30 @@ LocationServerpTask
         INT senderId;
         LOCATION_SERVER_REQUEST request;
 
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
+        // Update velocities whenever the interval passes, even if requests keep coming
+        INT result = ReceiveUntil(&senderId, &request, sizeof(request), nextVelocityUpdate);
+
+        if(RECEIVE_TIMED_OUT == result)
+        {
+            request.type = VelocityUpdateRequest;
+        }
+        else
+        {
+            VERIFY(SUCCESSFUL(result));
+        }
 
         switch(request.type)
         {
             case VelocityUpdateRequest:
             {
-                // Unblock the notifier ASAP
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
                 // Calculate all tracked train's updated locations
                 INT currentTime = Time();
                 ASSERT(SUCCESSFUL(currentTime));
 
-                LOCATION_SERVER_REGISTRAR_REQUEST request;
-                request.type = LocationUpdateRequest;
-                
+                nextVelocityUpdate = currentTime + LOCATION_SERVER_UPDATE_INTERVAL;
+
+                TRAIN_LOCATION trainLocation;
+
                 for(UINT i = 0; i < numTrackedTrains; i++)
                 {
                     TRAIN_DATA* trainData = &trackedTrains[i];
@@ -398,17 +292,14 @@ LocationServerpTask
                             trainData->location.distancePastNode += diff * trainData->velocity;
                             trainData->lastTimeLocationUpdated = currentTime;
 
-                            // Send the updated location to the registrar to send to any registrants
-                            request.trainLocation.train = trainData->train;
-                            request.trainLocation.location = LocationServerpFindActualLocation(&trainData->location);
-                            request.trainLocation.velocity = trainData->velocity;
-                            request.trainLocation.acceleration = LocationServerpAcceleration(trainData);
-                            request.trainLocation.accelerationTicks = trainData->accelerationTicks;
-
-                            UINT courierId = courierTasks[nextCourierTask];
-                            nextCourierTask = (nextCourierTask + 1) % MAX_TRACKABLE_TRAINS;
+                            // Send the updated location to any subscribers
+                            trainLocation.train = trainData->train;
+                            trainLocation.location = LocationServerpFindActualLocation(&trainData->location);
+                            trainLocation.velocity = trainData->velocity;
+                            trainLocation.acceleration = LocationServerpAcceleration(trainData);
+                            trainLocation.accelerationTicks = trainData->accelerationTicks;
 
-                            VERIFY(SUCCESSFUL(Send(courierId, &request, sizeof(request), NULL, 0)));
+                            VERIFY(SUCCESSFUL(Publish(g_locationTopic, &trainLocation, sizeof(trainLocation))));
                         }
                     }
                 }
@@ -418,9 +309,6 @@ LocationServerpTask
 
             case AttributedSensorUpdateRequest:
             {
-                // Unblock the notifier ASAP
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
                 // Get the data we have on this train
                 TRACK_NODE* sensorNode = TrackFindSensor(&request.attributedSensor.sensor);
                 TRAIN_DATA* trainData = LocationServerpFindTrainById(trackedTrains, numTrackedTrains, request.attributedSensor.train);
@@ -459,9 +347,6 @@ LocationServerpTask
 
             case SpeedUpdateRequest:
             {
-                // Unblock the notifier ASAP
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
                 // Try to find the train
                 TRAIN_DATA* trainData = LocationServerpFindTrainById(trackedTrains, numTrackedTrains, request.trainSpeed.train);
 
@@ -520,9 +405,6 @@ LocationServerpTask
 
             case DirectionUpdateRequest:
             {
-                // Unblock the notifier ASAP
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
                 // Update the train's point of reference
                 TRAIN_DATA* trainData = LocationServerpFindTrainById(trackedTrains, numTrackedTrains, request.trainDirection.train);
 
@@ -569,12 +451,13 @@ LocationServerpTask
 }
 
 VOID
-LocationServerCreateTask
+LocationServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority21, LocationServerpTask)));
+    g_locationTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_locationTopic));
 }
 
 INT
@@ -584,7 +467,7 @@ GetLocation
         OUT LOCATION* location
     )
 {
-    INT result = WhoIs(LOCATION_SERVER_NAME);
+    INT result = g_trainServiceIds[LocationService];
 
     if(SUCCESSFUL(result))
     {
@@ -606,17 +489,5 @@ LocationAwait
         OUT TRAIN_LOCATION* trainLocation
     )
 {
-    INT result = WhoIs(LOCATION_SERVER_REGISTRAR_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT locationServerRegistrarId = result;
-
-        LOCATION_SERVER_REGISTRAR_REQUEST request;
-        request.type = LocationAwaitRequest;
-
-        result = Send(locationServerRegistrarId, &request, sizeof(request), trainLocation, sizeof(*trainLocation));
-    }
-
-    return result;
+    return Subscribe(g_locationTopic, trainLocation, sizeof(*trainLocation));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-LocationServerCreateTask
+LocationServerInit
+    (
+        VOID
+    );
+
+VOID
+LocationServerTask
     (
         VOID
     );
@@ -6,41 +6,23 @@
 
 #include "display.h"
 
-#define NUM_PERFORMANCE_TASKS 21
 #define IDLE_TASK_ID 1
 
 VOID
-PerformancepTask
+PerformanceTask
     (
         VOID
     )
 {
-    TASK_PERFORMANCE performanceCounters[NUM_PERFORMANCE_TASKS];
-
     while (1)
     {
-        UINT totalTime = 0;
+        TASK_PERFORMANCE counters;
 
-        UINT i;
-        for (i = 0; i < NUM_PERFORMANCE_TASKS; i++)
+        if (SUCCESSFUL(QueryPerformance(IDLE_TASK_ID, &counters)))
         {
-            QueryPerformance(i, &performanceCounters[i]);
-            totalTime += performanceCounters[i].activeTicks;
+            ShowIdleTime(counters.utilization);
         }
 
-        INT idleTime = (performanceCounters[IDLE_TASK_ID].activeTicks / ((float) totalTime)) * 10000;
-
-        ShowIdleTime(idleTime);
-
         Delay(50);
     }
 }
-
-VOID
-PerformanceCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(LowestUserPriority, PerformancepTask)));
-}
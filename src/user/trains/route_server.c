@@ -2,15 +2,14 @@
 
 #include "display.h"
 #include "physics.h"
+#include "services.h"
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtosc/string.h>
 #include <rtkernel.h>
 #include <rtos.h>
 #include <track/track_data.h>
 #include <user/trains.h>
 
-#define ROUTE_SERVER_NAME "route"
 #define INFINITY 0xFFFFFFFF
 #define ROUTE_SERVER_MINIMUM_VELOCITY_TO_BE_CONFIDENT_IN_POSITION 3000
 #define ROUTE_SERVER_BLOCKING_DISTANCE 200 // 20 cm
@@ -21,8 +20,7 @@ typedef enum _ROUTE_REQUEST_TYPE
     LocationUpdateRequest = 0, 
     DirectionUpdateRequest, 
     SetDestinationRequest, 
-    ClearDestinationRequest,
-    AwaitRouteRequest
+    ClearDestinationRequest
 } ROUTE_REQUEST_TYPE;
 
 typedef struct _ROUTE_TO_DESTINATION_REQUEST
@@ -52,6 +50,8 @@ typedef struct _ROUTE_DATA
     PATH path;
 } ROUTE_DATA;
 
+static INT g_routeTopic;
+
 static
 VOID
 RouteServerpLocationNotifierTask
@@ -610,9 +610,8 @@ RouteServerpHasDestination
     return NULL != train->destination.node;
 }
 
-static
 VOID
-RouteServerpTask
+RouteServerTask
     (
         VOID
     )
@@ -626,13 +625,9 @@ RouteServerpTask
     DIRECTION directions[MAX_TRAINS];
     RtMemset(directions, sizeof(directions), DirectionForward);
 
-    INT underlyingAwaitingTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingTasks;
-    RtCircularBufferInit(&awaitingTasks, underlyingAwaitingTasksBuffer, sizeof(underlyingAwaitingTasksBuffer));
-
-    VERIFY(SUCCESSFUL(RegisterAs(ROUTE_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, RouteServerpLocationNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, RouteServerpDirectionChangeNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, RouteServerpLocationNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, RouteServerpDirectionChangeNotifierTask)));
 
     while(1)
     {
@@ -686,17 +681,12 @@ RouteServerpTask
                         // Remember the path
                         RtMemcpy(&trainData->path, optimalPath, sizeof(trainData->path));
 
-                        // Send the path to any registrants
+                        // Send the path to any subscribers
                         ROUTE route;
                         RtMemcpy(&route.trainLocation, &trainData->currentLocation, sizeof(route.trainLocation));
                         RtMemcpy(&route.path, &trainData->path, sizeof(route.path));
 
-                        INT awaitingTask;
-                        while(!RtCircularBufferIsEmpty(&awaitingTasks))
-                        {
-                            VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(&awaitingTasks, &awaitingTask, sizeof(awaitingTask))));
-                            VERIFY(SUCCESSFUL(Reply(awaitingTask, &route, sizeof(route))));
-                        }
+                        VERIFY(SUCCESSFUL(Publish(g_routeTopic, &route, sizeof(route))));
                     }
                 }
 
@@ -743,12 +733,6 @@ RouteServerpTask
                 break;
             }
 
-            case AwaitRouteRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingTasks, &senderId, sizeof(senderId))));
-                break;
-            }
-
             default:
             {
                 ASSERT(FALSE);
@@ -759,12 +743,13 @@ RouteServerpTask
 }
 
 VOID
-RouteServerCreate
+RouteServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority20, RouteServerpTask)));
+    g_routeTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_routeTopic));
 }
 
 INT
@@ -774,7 +759,7 @@ RouteTrainToDestination
         IN LOCATION* destination
     )
 {
-    INT result = WhoIs(ROUTE_SERVER_NAME);
+    INT result = g_trainServiceIds[RouteService];
 
     if(SUCCESSFUL(result))
     {
@@ -797,7 +782,7 @@ RouteClearDestination
         IN UCHAR train
     )
 {
-    INT result = WhoIs(ROUTE_SERVER_NAME);
+    INT result = g_trainServiceIds[RouteService];
 
     if(SUCCESSFUL(result))
     {
@@ -819,17 +804,5 @@ RouteAwait
         OUT ROUTE* route
     )
 {
-    INT result = WhoIs(ROUTE_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT routeServerId = result;
-
-        ROUTE_REQUEST request;
-        request.type = AwaitRouteRequest;
-
-        result = Send(routeServerId, &request, sizeof(request), route, sizeof(*route));
-    }
-
-    return result;
+    return Subscribe(g_routeTopic, route, sizeof(*route));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-RouteServerCreate
+RouteServerInit
+    (
+        VOID
+    );
+
+VOID
+RouteServerTask
     (
         VOID
     );
@@ -80,15 +80,15 @@ SafetypCheckTrain
     }
 }
 
-static
 VOID
-SafetypTask
+SafetyTask
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, SafetypAttributedSensorNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, SafetypSwitchNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, SafetypAttributedSensorNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, SafetypSwitchNotifierTask)));
 
     while(1)
     {
@@ -128,12 +128,3 @@ SafetypTask
         }
     }
 }
-
-VOID
-SafetyCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority17, SafetypTask)));
-}
@@ -8,8 +8,6 @@
 #include <rtos.h>
 #include <user/trains.h>
 
-#define SCHEDULER_NAME "scheduler"
-
 #define SCHEDULER_TRAIN_NOT_MOVING_THRESHOLD 100
 
 // Debug builds are slower than release builds
@@ -83,9 +81,8 @@ SchedulerpAttributedSensorNotifierTask
     }
 }
 
-static
 VOID
-SchedulerpTask
+SchedulerTask
     (
         VOID
     )
@@ -93,9 +90,9 @@ SchedulerpTask
     TRAIN_SCHEDULE trainSchedules[MAX_TRAINS];
     RtMemset(trainSchedules, sizeof(trainSchedules), 0);
 
-    VERIFY(SUCCESSFUL(RegisterAs(SCHEDULER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, SchedulerpLocationNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, SchedulerpAttributedSensorNotifierTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, SchedulerpLocationNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, SchedulerpAttributedSensorNotifierTask)));
 
     while(1)
     {
@@ -197,12 +194,3 @@ SchedulerpTask
         }
     }
 }
-
-VOID
-SchedulerCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority16, SchedulerpTask)));
-}
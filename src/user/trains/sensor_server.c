@@ -4,28 +4,15 @@
 #include <rtos.h>
 #include <user/trains.h>
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtosc/bitset.h>
 #include <rtosc/string.h>
 
 #include "display.h"
 
-#define SENSOR_SERVER_NAME "sensor"
-
 #define NUM_SENSORS 10
 #define SENSOR_COMMAND_QUERY 0x85
 
-typedef enum _SENSOR_SERVER_REQUEST_TYPE
-{
-    RegisterRequest = 0,
-    DataRequest
-} SENSOR_SERVER_REQUEST_TYPE;
-
-typedef struct _SENSOR_SERVER_REQUEST
-{
-    SENSOR_SERVER_REQUEST_TYPE type;
-    SENSOR_DATA sensorData;
-} SENSOR_SERVER_REQUEST;
+static INT g_sensorTopic;
 
 static
 VOID
@@ -55,22 +42,19 @@ SensorServerpNotifierTask
     }
 }
 
-static
+// Publishing never blocks, so the delta task can tell subscribers itself
 VOID
-SensorServerpDeltaTask
+SensorServerTask
     (
         VOID
     )
 {
-    SENSOR_SERVER_REQUEST request;
-    request.type = DataRequest;
+    SENSOR_DATA sensorData;
 
     UCHAR previousSensors[NUM_SENSORS];
     RtMemset(previousSensors, sizeof(previousSensors), 0);
 
-    INT sensorServerId = MyParentTid();
-    ASSERT(SUCCESSFUL(sensorServerId));    
-    
+    EnablePriorityInheritance();
     VERIFY(SUCCESSFUL(Create(HighestUserPriority, SensorServerpNotifierTask)));
 
     while(1)
@@ -96,11 +80,12 @@ SensorServerpDeltaTask
                 // Check to see if the sensor has changed
                 if(previousValue != currentValue)
                 {
-                    request.sensorData.sensor.module = 'A' + (i / 2);
-                    request.sensorData.sensor.number = (8 - j) + ((i % 2) * 8);
-                    request.sensorData.isOn = currentValue;
+                    sensorData.sensor.module = 'A' + (i / 2);
+                    sensorData.sensor.number = (8 - j) + ((i % 2) * 8);
+                    sensorData.isOn = currentValue;
 
-                    VERIFY(SUCCESSFUL(Send(sensorServerId, &request, sizeof(request), NULL, 0)));
+                    // Tell any subscribers about the tripped sensor
+                    VERIFY(SUCCESSFUL(Publish(g_sensorTopic, &sensorData, sizeof(sensorData))));
                 }
             }
         }
@@ -110,58 +95,14 @@ SensorServerpDeltaTask
     }
 }
 
-static
 VOID
-SensorServerpTask
+SensorServerInit
     (
         VOID
     )
 {
-    INT underlyingSubscriberBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER subscriberBuffer;
-    RtCircularBufferInit(&subscriberBuffer, underlyingSubscriberBuffer, sizeof(underlyingSubscriberBuffer));
-
-    VERIFY(SUCCESSFUL(RegisterAs(SENSOR_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(Priority13, SensorServerpDeltaTask)));
-
-    while (1)
-    {
-        INT senderId;
-        SENSOR_SERVER_REQUEST request;
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-
-        switch (request.type)
-        {
-            case RegisterRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&subscriberBuffer, &senderId, sizeof(senderId))));
-                break;
-            }
-
-            case DataRequest:
-            {
-                // Tell any registrants about the tripped sensor
-                INT subscriberId;
-                while(RT_SUCCESS(RtCircularBufferPeekAndPop(&subscriberBuffer, &subscriberId, sizeof(subscriberId))))
-                {
-                    VERIFY(SUCCESSFUL(Reply(subscriberId, &request.sensorData, sizeof(request.sensorData))));
-                }
-
-                // Unblock the delta task
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));                
-                break;
-            }
-        }
-    }
-}
-
-VOID
-SensorServerCreateTask
-    (
-        VOID
-    )
-{
-    VERIFY(SUCCESSFUL(Create(Priority25, SensorServerpTask)));
+    g_sensorTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_sensorTopic));
 }
 
 INT
@@ -170,16 +111,5 @@ SensorAwait
         OUT SENSOR_DATA* sensorData
     )
 {
-    INT result = WhoIs(SENSOR_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT sensorServerId = result;
-        SENSOR_SERVER_REQUEST request;
-        request.type = RegisterRequest;
-
-        result = Send(sensorServerId, &request, sizeof(request), sensorData, sizeof(*sensorData));
-    }
-
-    return result;
+    return Subscribe(g_sensorTopic, sensorData, sizeof(*sensorData));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-SensorServerCreateTask
+SensorServerInit
+    (
+        VOID
+    );
+
+VOID
+SensorServerTask
     (
         VOID
     );
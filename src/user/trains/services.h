@@ -0,0 +1,27 @@
+#pragma once
+
+#include <rt.h>
+
+// Tasks created by InitTrainTasks.  Clients index
+// g_trainServiceIds instead of asking the name server.
+typedef enum _TRAIN_SERVICE
+{
+    DisplayService = 0, 
+    ClockDisplayService, 
+    PerformanceDisplayService, 
+    InputParserService, 
+    SensorService, 
+    TrainService, 
+    SwitchService, 
+    AttributionService, 
+    LocationService, 
+    RouteService, 
+    StopService, 
+    ConductorService, 
+    SafetyService, 
+    SchedulerService, 
+    DestinationService, 
+    NumTrainService
+} TRAIN_SERVICE;
+
+extern INT g_trainServiceIds[NumTrainService];
@@ -2,21 +2,19 @@
 
 #include "display.h"
 #include "physics.h"
+#include "services.h"
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtosc/string.h>
 #include <rtkernel.h>
 #include <rtos.h>
 #include <user/trains.h>
 
-#define STOP_SERVER_NAME "stop"
-#define STOP_SERVER_REGISTRAR_NAME "stop_registrar"
-
 typedef enum _STOP_SERVER_REQUEST_TYPE
 {
     RouteUpdateRequest = 0,
     DirectionUpdateRequest,
-    StopTrainAtLocationRequest
+    StopTrainAtLocationRequest,
+    DestinationReachedRequest
 } STOP_SERVER_REQUEST_TYPE;
 
 typedef struct _STOP_AT_LOCATION_REQUEST
@@ -34,26 +32,11 @@ typedef struct _STOP_SERVER_REQUEST
         ROUTE route;
         TRAIN_DIRECTION trainDirection;
         STOP_AT_LOCATION_REQUEST stopAtLocation;
+        DESTINATION_REACHED destinationReached;
     };
 } STOP_SERVER_REQUEST;
 
-typedef enum _STOP_SERVER_REGISTRAR_REQUEST_TYPE
-{
-    RegisterRequest = 0, 
-    DestinationReachedRequest
-} STOP_SERVER_REGISTRAR_REQUEST_TYPE;
-
-typedef struct _STOP_SERVER_REGISTRAR_REQUEST
-{
-    STOP_SERVER_REGISTRAR_REQUEST_TYPE type;
-    DESTINATION_REACHED destinationReached;
-} STOP_SERVER_REGISTRAR_REQUEST;
-
-typedef struct _STOP_SERVER_WORKER_REQUEST
-{
-    UINT delayTime;
-    DESTINATION_REACHED destinationReached;
-} STOP_SERVER_WORKER_REQUEST;
+static INT g_destinationReachedTopic;
 
 static
 VOID
@@ -95,89 +78,8 @@ StopServerpDirectionChangeNotifierTask
     }
 }
 
-static
-VOID
-StopServerpRegistrarTask
-    (
-        VOID
-    )
-{
-    INT underlyingAwaitingTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingTasks;
-    RtCircularBufferInit(&awaitingTasks, underlyingAwaitingTasksBuffer, sizeof(underlyingAwaitingTasksBuffer));
-
-    VERIFY(SUCCESSFUL(RegisterAs(STOP_SERVER_REGISTRAR_NAME)));
-
-    while(1)
-    {
-        INT senderId;
-        STOP_SERVER_REGISTRAR_REQUEST request;
-
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-
-        switch(request.type)
-        {
-            case RegisterRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingTasks, &senderId, sizeof(senderId))));
-                break;
-            }
-
-            case DestinationReachedRequest:
-            {
-                // Send the event to any tasks waiting on the event
-                INT awaitingTask;
-                while(!RtCircularBufferIsEmpty(&awaitingTasks))
-                {
-                    VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(&awaitingTasks, &awaitingTask, sizeof(awaitingTask))));
-                    VERIFY(SUCCESSFUL(Reply(awaitingTask, &request.destinationReached, sizeof(request.destinationReached))));
-                }
-
-                // Reply to the worker task
-                VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-                break;
-            }
-
-            default:
-            {
-                ASSERT(FALSE);
-                break;
-            }
-        }
-    }
-}
-
-static
-VOID
-StopServerpWorkerTask
-    (
-        VOID
-    )
-{
-    INT stopServerRegistrarId = WhoIs(STOP_SERVER_REGISTRAR_NAME);
-    ASSERT(SUCCESSFUL(stopServerRegistrarId));
-
-    STOP_SERVER_REGISTRAR_REQUEST registrarRequest;
-    registrarRequest.type = DestinationReachedRequest;
-
-    while(1)
-    {
-        INT senderId;
-        STOP_SERVER_WORKER_REQUEST request;
-
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-        VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
-        registrarRequest.destinationReached = request.destinationReached;
-
-        VERIFY(SUCCESSFUL(Delay(request.delayTime)));
-        VERIFY(SUCCESSFUL(Send(stopServerRegistrarId, &registrarRequest, sizeof(registrarRequest), NULL, 0)));
-    }
-}
-
-static
 VOID
-StopServerpTask
+StopServerTask
     (
         VOID
     )
@@ -188,26 +90,19 @@ StopServerpTask
     DIRECTION directions[MAX_TRAINS];
     RtMemset(directions, sizeof(directions), DirectionForward);
 
-    VERIFY(SUCCESSFUL(RegisterAs(STOP_SERVER_NAME)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, StopServerpRouteNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(HighestUserPriority, StopServerpDirectionChangeNotifierTask)));
-    VERIFY(SUCCESSFUL(Create(Priority13, StopServerpRegistrarTask)));
+    EnablePriorityInheritance();
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, StopServerpRouteNotifierTask)));
+    VERIFY(SUCCESSFUL(CreateEx(HighestUserPriority, MediumStack, StopServerpDirectionChangeNotifierTask)));
 
-    INT workerTasks[MAX_TRACKABLE_TRAINS];
-    UINT nextWorkerTask = 0;
-
-    for(UINT i = 0; i < MAX_TRACKABLE_TRAINS; i++)
-    {
-        workerTasks[i] = Create(Priority12, StopServerpWorkerTask);
-        ASSERT(SUCCESSFUL(workerTasks[i]));
-    }
+    DEFERRED_SENDS deferredSends;
+    DeferredSendsInit(&deferredSends);
 
     while(1)
     {
         INT senderId;
         STOP_SERVER_REQUEST request;
 
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
+        VERIFY(SUCCESSFUL(ReceiveDeferred(&deferredSends, &senderId, &request, sizeof(request))));
 
         switch(request.type)
         {
@@ -242,13 +137,18 @@ StopServerpTask
                         VERIFY(SUCCESSFUL(TrainSetSpeed(request.route.trainLocation.train, 0)));
 
                         // Once the train has stopped, let other tasks know that the train has reached its destination
-                        STOP_SERVER_WORKER_REQUEST workerRequest;
-                        workerRequest.delayTime = PhysicsStoppingTime(request.route.trainLocation.train, endingVelocity);
-                        workerRequest.destinationReached.train = request.route.trainLocation.train;
-                        workerRequest.destinationReached.location = *stopLocation;
+                        STOP_SERVER_REQUEST reachedRequest;
+                        reachedRequest.type = DestinationReachedRequest;
+                        reachedRequest.destinationReached.train = request.route.trainLocation.train;
+                        reachedRequest.destinationReached.location = *stopLocation;
+
+                        // The route in the union is far too big to post, so only send what we use
+                        INT reachedRequestLength = (PCHAR) (&reachedRequest.destinationReached + 1) - (PCHAR) &reachedRequest;
 
-                        VERIFY(SUCCESSFUL(Send(workerTasks[nextWorkerTask], &workerRequest, sizeof(workerRequest), NULL, 0)));
-                        nextWorkerTask = (nextWorkerTask + 1) % MAX_TRACKABLE_TRAINS;
+                        VERIFY(SUCCESSFUL(DelayedSendSelf(&deferredSends,
+                                                          &reachedRequest,
+                                                          reachedRequestLength,
+                                                          PhysicsStoppingTime(request.route.trainLocation.train, endingVelocity))));
 
                         // The train no longer has stop location
                         stopLocation->node = NULL;
@@ -273,6 +173,13 @@ StopServerpTask
                 break;
             }
 
+            case DestinationReachedRequest:
+            {
+                // We sent this to ourselves, so there is nobody to reply to
+                VERIFY(SUCCESSFUL(Publish(g_destinationReachedTopic, &request.destinationReached, sizeof(request.destinationReached))));
+                break;
+            }
+
             default:
             {
                 ASSERT(FALSE);
@@ -284,12 +191,13 @@ StopServerpTask
 }
 
 VOID
-StopServerCreate
+StopServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority19, StopServerpTask)));
+    g_destinationReachedTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_destinationReachedTopic));
 }
 
 INT
@@ -299,7 +207,7 @@ StopTrainAtLocation
         IN LOCATION* location
     )
 {
-    INT result = WhoIs(STOP_SERVER_NAME);
+    INT result = g_trainServiceIds[StopService];
 
     if(SUCCESSFUL(result))
     {
@@ -322,17 +230,5 @@ DestinationReachedAwait
         OUT DESTINATION_REACHED* destinationReached
     )
 {
-    INT result = WhoIs(STOP_SERVER_REGISTRAR_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT stopServerRegistrarId = result;
-
-        STOP_SERVER_REGISTRAR_REQUEST request;
-        request.type = RegisterRequest;
-
-        result = Send(stopServerRegistrarId, &request, sizeof(request), destinationReached, sizeof(*destinationReached));
-    }
-
-    return result;
+    return Subscribe(g_destinationReachedTopic, destinationReached, sizeof(*destinationReached));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-StopServerCreate
+StopServerInit
+    (
+        VOID
+    );
+
+VOID
+StopServerTask
     (
         VOID
     );
@@ -2,14 +2,12 @@
 
 #include "display.h"
 #include "location_server.h"
+#include "services.h"
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtkernel.h>
 #include <rtos.h>
 #include <user/trains.h>
 
-#define SWITCH_SERVER_NAME "switch"
-
 #define NUM_SWITCHES 22
 #define SWITCH_COMMAND_DISABLE_SOLENOID 0x20
 #define SWITCH_COMMAND_DIRECTION_STRAIGHT 0x21
@@ -18,8 +16,7 @@
 typedef enum _SWITCH_REQUEST_TYPE
 {
     SetDirectionRequest = 0, 
-    GetDirectionRequest, 
-    AwaitChangeRequest
+    GetDirectionRequest
 } SWITCH_REQUEST_TYPE;
 
 typedef struct _SWITCH_REQUEST
@@ -29,6 +26,8 @@ typedef struct _SWITCH_REQUEST
     SWITCH_DIRECTION direction;
 } SWITCH_REQUEST;
 
+static INT g_switchChangeTopic;
+
 // Really hacky conversion of a switch to an index in a buffer
 static
 UINT
@@ -125,21 +124,14 @@ SwitchpDisableSolenoid
     return SwitchpSendOneByteCommand(device, SWITCH_COMMAND_DISABLE_SOLENOID);
 }
 
-static
 VOID
-SwitchpTask
+SwitchServerTask
     (
         VOID
     )
 {
-    INT underlyingAwaitingTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingTasks;
-    RtCircularBufferInit(&awaitingTasks, underlyingAwaitingTasksBuffer, sizeof(underlyingAwaitingTasksBuffer));
-
     SWITCH_DIRECTION directions[NUM_SWITCHES];
 
-    VERIFY(SUCCESSFUL(RegisterAs(SWITCH_SERVER_NAME)));
-
     IO_DEVICE com1;
     VERIFY(SUCCESSFUL(Open(UartDevice, ChannelCom1, &com1)));
 
@@ -179,12 +171,8 @@ SwitchpTask
 
                     VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
 
-                    INT awaitingTask;
-                    while(!RtCircularBufferIsEmpty(&awaitingTasks))
-                    {
-                        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(&awaitingTasks, &awaitingTask, sizeof(awaitingTask))));
-                        VERIFY(SUCCESSFUL(Reply(awaitingTask, &request.sw, sizeof(request.sw))));
-                    }
+                    INT sw = request.sw;
+                    VERIFY(SUCCESSFUL(Publish(g_switchChangeTopic, &sw, sizeof(sw))));
 
                     ShowSwitchDirection(switchIndex, request.sw, request.direction);
                 }
@@ -204,12 +192,6 @@ SwitchpTask
                 break;
             }
 
-            case AwaitChangeRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingTasks, &sender, sizeof(sender))));
-                break;
-            }
-
             default:
             {
                 ASSERT(FALSE);
@@ -220,12 +202,13 @@ SwitchpTask
 }
 
 VOID
-SwitchServerCreate
+SwitchServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority23, SwitchpTask)));
+    g_switchChangeTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_switchChangeTopic));
 }
 
 INT
@@ -240,7 +223,7 @@ SwitchSetDirection
 
     if(index < NUM_SWITCHES)
     {
-        result = WhoIs(SWITCH_SERVER_NAME);
+        result = g_trainServiceIds[SwitchService];
 
         if(SUCCESSFUL(result))
         {
@@ -270,7 +253,7 @@ SwitchGetDirection
 
     if(index < NUM_SWITCHES)
     {
-        result = WhoIs(SWITCH_SERVER_NAME);
+        result = g_trainServiceIds[SwitchService];
 
         if(SUCCESSFUL(result))
         {
@@ -294,17 +277,5 @@ SwitchChangeAwait
         OUT INT* sw
     )
 {
-    INT result = WhoIs(SWITCH_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT switchServerId = result;
-
-        SWITCH_REQUEST request;
-        request.type = AwaitChangeRequest;
-
-        result = Send(switchServerId, &request, sizeof(request), sw, sizeof(*sw));
-    }
-
-    return result;
+    return Subscribe(g_switchChangeTopic, sw, sizeof(*sw));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-SwitchServerCreate
+SwitchServerInit
+    (
+        VOID
+    );
+
+VOID
+SwitchServerTask
     (
         VOID
     );
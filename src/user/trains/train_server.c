@@ -1,7 +1,6 @@
 #include "train_server.h"
 
 #include <rtosc/assert.h>
-#include <rtosc/buffer.h>
 #include <rtosc/string.h>
 #include <rtkernel.h>
 #include <rtos.h>
@@ -9,8 +8,8 @@
 
 #include "display.h"
 #include "location_server.h"
+#include "services.h"
 
-#define TRAIN_SERVER_NAME "train"
 #define NUM_TRAINS 80
 
 #define TRAIN_COMMAND_REVERSE 0xF
@@ -23,9 +22,7 @@ typedef enum _TRAIN_REQUEST_TYPE
     SetSpeedRequest,
     GetSpeedRequest,
     ReverseRequest, 
-    ReverseStoppedRequest, 
-    AwaitSpeedChangeRequest, 
-    AwaitDirectionChangeRequest
+    ReverseStoppedRequest
 } TRAIN_REQUEST_TYPE;
 
 typedef struct _TRAIN_REQUEST
@@ -35,11 +32,8 @@ typedef struct _TRAIN_REQUEST
     UCHAR speed;
 } TRAIN_REQUEST;
 
-typedef struct _TRAIN_WORKER_REQUEST
-{
-    INT delay;
-    TRAIN_REQUEST request;
-} TRAIN_WORKER_REQUEST;
+static INT g_speedChangeTopic;
+static INT g_directionChangeTopic;
 
 static
 INT
@@ -48,7 +42,7 @@ TrainpSendRequest
         IN TRAIN_REQUEST* request
     )
 {
-    INT result = WhoIs(TRAIN_SERVER_NAME);
+    INT result = g_trainServiceIds[TrainService];
 
     if(SUCCESSFUL(result))
     {
@@ -141,79 +135,12 @@ TrainpReverse
     return TrainpSendTwoByteCommand(device, TRAIN_COMMAND_REVERSE, train);
 }
 
-static
 VOID
-TrainpWorkerTask
+TrainServerTask
     (
         VOID
     )
 {
-    // TODO - Something like DelayedSend would be so much better than worker tasks
-    while(1)
-    {
-        INT senderId;
-        TRAIN_WORKER_REQUEST request;
-
-        // Wait for a request from the train server
-        VERIFY(SUCCESSFUL(Receive(&senderId, &request, sizeof(request))));
-        VERIFY(SUCCESSFUL(Reply(senderId, NULL, 0)));
-
-        // Delay for a bit
-        VERIFY(SUCCESSFUL(Delay(request.delay)));
-
-        // Notify the train server
-        VERIFY(SUCCESSFUL(Send(senderId, &request.request, sizeof(request.request), NULL, 0)));
-    }
-}
-
-static
-VOID
-TrainpNotifySpeedChange
-    (
-        RT_CIRCULAR_BUFFER* awaitingSpeedChangeTasks, 
-        UCHAR train, 
-        UCHAR speed
-    )
-{
-    INT awaitingTask;
-    TRAIN_SPEED trainSpeed = { train, speed };
-
-    while(!RtCircularBufferIsEmpty(awaitingSpeedChangeTasks))
-    {
-        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(awaitingSpeedChangeTasks, &awaitingTask, sizeof(awaitingTask))));
-        VERIFY(SUCCESSFUL(Reply(awaitingTask, &trainSpeed, sizeof(trainSpeed))));
-    }
-}
-
-static
-VOID
-TrainpNotifyDirectionChange
-    (
-        RT_CIRCULAR_BUFFER* awaitingDirectionChangeTasks, 
-        UCHAR train, 
-        DIRECTION direction
-    )
-{
-    INT awaitingTask;
-    TRAIN_DIRECTION trainDirection = { train, direction };
-
-    while(!RtCircularBufferIsEmpty(awaitingDirectionChangeTasks))
-    {
-        VERIFY(RT_SUCCESS(RtCircularBufferPeekAndPop(awaitingDirectionChangeTasks, &awaitingTask, sizeof(awaitingTask))));
-        VERIFY(SUCCESSFUL(Reply(awaitingTask, &trainDirection, sizeof(trainDirection))));
-    }
-}
-
-static
-VOID
-TrainpTask
-    (
-        VOID
-    )
-{
-    // Make the server global visible
-    VERIFY(SUCCESSFUL(RegisterAs(TRAIN_SERVER_NAME)));
-
     // On shutdown, stop all trains
     VERIFY(SUCCESSFUL(ShutdownRegisterHook(TrainpShutdownHook)));
 
@@ -231,38 +158,28 @@ TrainpTask
     VERIFY(SUCCESSFUL(TrainpSetSpeed(&com1, 68, 0)));
     VERIFY(SUCCESSFUL(TrainpSetSpeed(&com1, 69, 0)));
 
-    // Create worker tasks
-    INT workerTasks[MAX_TRACKABLE_TRAINS];
-    UINT nextWorkerTask = 0;
-    for(UINT i = 0; i < MAX_TRACKABLE_TRAINS; i++)
-    {
-        workerTasks[i] = Create(Priority12, TrainpWorkerTask);
-        ASSERT(SUCCESSFUL(workerTasks[i]));
-    }
-
     // Initialize variables
     BOOLEAN running = TRUE;
 
+    // Reversing a train is finished by messages the server posts to itself
+    INT trainServerId = MyTid();
+    ASSERT(SUCCESSFUL(trainServerId));
+
+    DEFERRED_SENDS deferredSends;
+    DeferredSendsInit(&deferredSends);
+
     UCHAR speeds[NUM_TRAINS];
     RtMemset(speeds, sizeof(speeds), 0);
 
     DIRECTION directions[NUM_TRAINS];
     RtMemset(directions, sizeof(directions), DirectionForward);
 
-    INT underlyingAwaitingSpeedChangeTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingSpeedChangeTasks;
-    RtCircularBufferInit(&awaitingSpeedChangeTasks, underlyingAwaitingSpeedChangeTasksBuffer, sizeof(underlyingAwaitingSpeedChangeTasksBuffer));
-
-    INT underlyingAwaitingDirectionChangeTasksBuffer[NUM_TASKS];
-    RT_CIRCULAR_BUFFER awaitingDirectionChangeTasks;
-    RtCircularBufferInit(&awaitingDirectionChangeTasks, underlyingAwaitingDirectionChangeTasksBuffer, sizeof(underlyingAwaitingDirectionChangeTasksBuffer));
-
     while(running)
     {
         INT sender;
         TRAIN_REQUEST request;
 
-        VERIFY(SUCCESSFUL(Receive(&sender, &request, sizeof(request))));
+        VERIFY(SUCCESSFUL(ReceiveDeferred(&deferredSends, &sender, &request, sizeof(request))));
 
         switch(request.type)
         {
@@ -288,11 +205,16 @@ TrainpTask
                     speeds[request.train - 1] = request.speed;
                     VERIFY(SUCCESSFUL(TrainpSetSpeed(&com1, request.train, request.speed)));
                 }
-                
-                VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
+
+                // Nobody is waiting if this finishes a reverse
+                if(sender != trainServerId)
+                {
+                    VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
+                }
 
                 // Let tasks know about the train's new speed
-                TrainpNotifySpeedChange(&awaitingSpeedChangeTasks, request.train, request.speed);
+                TRAIN_SPEED trainSpeed = { request.train, request.speed };
+                VERIFY(SUCCESSFUL(Publish(g_speedChangeTopic, &trainSpeed, sizeof(trainSpeed))));
                 break;
             }
 
@@ -305,20 +227,18 @@ TrainpTask
                 speeds[request.train - 1] = 0;
                 VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
 
-                // Schedule a task to reverse the train's direction after it has come to a stop
-                TRAIN_WORKER_REQUEST workerRequest;
-                workerRequest.delay = 0 == oldSpeed ? 10 : 100 * (oldSpeed / 4 + 1); // TODO - More accurate stopping time
-                workerRequest.request.type = ReverseStoppedRequest;
-                workerRequest.request.train = request.train;
-                workerRequest.request.speed = oldSpeed;
+                // Reverse the train's direction after it has come to a stop
+                TRAIN_REQUEST stoppedRequest;
+                stoppedRequest.type = ReverseStoppedRequest;
+                stoppedRequest.train = request.train;
+                stoppedRequest.speed = oldSpeed;
 
-                INT nextWorkerTaskId = workerTasks[nextWorkerTask % MAX_TRACKABLE_TRAINS];
-                nextWorkerTask++;
-
-                VERIFY(SUCCESSFUL(Send(nextWorkerTaskId, &workerRequest, sizeof(workerRequest), NULL, 0)));
+                INT stoppingTime = 0 == oldSpeed ? 10 : 100 * (oldSpeed / 4 + 1); // TODO - More accurate stopping time
+                VERIFY(SUCCESSFUL(DelayedSendSelf(&deferredSends, &stoppedRequest, sizeof(stoppedRequest), stoppingTime)));
 
                 // Let tasks know the train is stopping
-                TrainpNotifySpeedChange(&awaitingSpeedChangeTasks, request.train, 0);
+                TRAIN_SPEED trainSpeed = { request.train, 0 };
+                VERIFY(SUCCESSFUL(Publish(g_speedChangeTopic, &trainSpeed, sizeof(trainSpeed))));
                 break;
             }
 
@@ -326,7 +246,6 @@ TrainpTask
             {
                 // Reverse the train
                 VERIFY(SUCCESSFUL(TrainpReverse(&com1, request.train)));
-                VERIFY(SUCCESSFUL(Reply(sender, NULL, 0)));
 
                 // Figure out which direction this train is now travelling
                 DIRECTION newDirection;
@@ -342,32 +261,17 @@ TrainpTask
 
                 directions[request.train - 1] = newDirection;
 
-                // Schedule a task to speed the train back up
-                TRAIN_WORKER_REQUEST workerRequest;
-                workerRequest.delay = 5; // TODO - Why do we need this?
-                workerRequest.request.type = SetSpeedRequest;
-                workerRequest.request.train = request.train;
-                workerRequest.request.speed = request.speed;
+                // Speed the train back up
+                TRAIN_REQUEST speedRequest;
+                speedRequest.type = SetSpeedRequest;
+                speedRequest.train = request.train;
+                speedRequest.speed = request.speed;
 
-                INT nextWorkerTaskId = workerTasks[nextWorkerTask % MAX_TRACKABLE_TRAINS];
-                nextWorkerTask++;
-                
-                VERIFY(SUCCESSFUL(Send(nextWorkerTaskId, &workerRequest, sizeof(workerRequest), NULL, 0)));
+                VERIFY(SUCCESSFUL(DelayedSendSelf(&deferredSends, &speedRequest, sizeof(speedRequest), 5))); // TODO - Why do we need this?
 
                 // Let tasks know about the new direction
-                TrainpNotifyDirectionChange(&awaitingDirectionChangeTasks, request.train, newDirection);
-                break;
-            }
-
-            case AwaitSpeedChangeRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingSpeedChangeTasks, &sender, sizeof(sender))));
-                break;
-            }
-
-            case AwaitDirectionChangeRequest:
-            {
-                VERIFY(RT_SUCCESS(RtCircularBufferPush(&awaitingDirectionChangeTasks, &sender, sizeof(sender))));
+                TRAIN_DIRECTION trainDirection = { request.train, newDirection };
+                VERIFY(SUCCESSFUL(Publish(g_directionChangeTopic, &trainDirection, sizeof(trainDirection))));
                 break;
             }
 
@@ -404,7 +308,7 @@ TrainGetSpeed
         return -1;
     }
 
-    INT result = WhoIs(TRAIN_SERVER_NAME);
+    INT result = g_trainServiceIds[TrainService];
 
     if(SUCCESSFUL(result))
     {
@@ -444,19 +348,7 @@ TrainSpeedChangeAwait
         OUT TRAIN_SPEED* trainSpeed
     )
 {
-    INT result = WhoIs(TRAIN_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT trainServerId = result;
-
-        TRAIN_REQUEST request;
-        request.type = AwaitSpeedChangeRequest;
-
-        result = Send(trainServerId, &request, sizeof(request), trainSpeed, sizeof(*trainSpeed));
-    }
-
-    return result;
+    return Subscribe(g_speedChangeTopic, trainSpeed, sizeof(*trainSpeed));
 }
 
 INT
@@ -480,26 +372,19 @@ TrainDirectionChangeAwait
         OUT TRAIN_DIRECTION* trainDirection
     )
 {
-    INT result = WhoIs(TRAIN_SERVER_NAME);
-
-    if(SUCCESSFUL(result))
-    {
-        INT trainServerId = result;
-
-        TRAIN_REQUEST request;
-        request.type = AwaitDirectionChangeRequest;
-
-        result = Send(trainServerId, &request, sizeof(request), trainDirection, sizeof(*trainDirection));
-    }
-
-    return result;
+    return Subscribe(g_directionChangeTopic, trainDirection, sizeof(*trainDirection));
 }
 
 VOID
-TrainServerCreate
+TrainServerInit
     (
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(Priority24, TrainpTask)));
+    // Create the topics before anyone can subscribe to them
+    g_speedChangeTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_speedChangeTopic));
+
+    g_directionChangeTopic = CreateTopic();
+    ASSERT(SUCCESSFUL(g_directionChangeTopic));
 }
@@ -3,7 +3,13 @@
 #include <rt.h>
 
 VOID
-TrainServerCreate
+TrainServerInit
+    (
+        VOID
+    );
+
+VOID
+TrainServerTask
     (
         VOID
     );
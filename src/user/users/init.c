@@ -11,5 +11,6 @@ InitUserTasks
         VOID
     )
 {
-    VERIFY(SUCCESSFUL(Create(LowestUserPriority, InitTrainTasks)));
+    // The train services must not run until all of them have been created
+    VERIFY(SUCCESSFUL(Create(HighestUserPriority, InitTrainTasks)));
 }
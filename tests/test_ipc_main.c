@@ -0,0 +1,347 @@
+#include <bwio/bwio.h>
+#include <rtosc/assert.h>
+#include <rt.h>
+#include <rtos.h>
+#include "clock.h"
+#include "ipc.h"
+#include "scheduler.h"
+#include "task.h"
+
+static UINT g_serverStack[64];
+static UINT g_clientStack[64];
+static UINT g_otherClientStack[64];
+static UINT g_senderStack[64];
+static UINT g_receiverStacks[3][64];
+static UINT g_posterStack[64];
+static UINT g_postReceiverStacks[2][64];
+
+static
+TASK_DESCRIPTOR*
+TestpCreateTask
+    (
+        IN TASK_PRIORITY priority,
+        IN UINT* stack
+    )
+{
+    TASK_DESCRIPTOR* td;
+
+    T_ASSERT(RT_SUCCESS(TaskDescriptorAllocate(&td)));
+
+    td->stackPointer = &stack[32];
+    td->priority = priority;
+    td->basePriority = priority;
+    td->state = ReadyState;
+    td->inheritPriority = FALSE;
+    td->timeoutPending = FALSE;
+    IpcInitializeMailbox(td);
+
+    return td;
+}
+
+static
+VOID
+TestpRun
+    (
+        IN TASK_DESCRIPTOR* expectedTask
+    )
+{
+    TASK_DESCRIPTOR* nextTask;
+
+    T_ASSERT(RT_SUCCESS(SchedulerGetNextTask(&nextTask)));
+    bwprintf(BWCOM2, "Got task %d \r\n", nextTask->taskId);
+    T_ASSERT(expectedTask == nextTask);
+
+    // The kernel marks the task it picks as running
+    nextTask->state = RunningState;
+}
+
+static
+VOID
+TestpTimeouts
+    (
+        VOID
+    )
+{
+    TASK_DESCRIPTOR* sender = TestpCreateTask(HighestUserPriority, g_senderStack);
+    TASK_DESCRIPTOR* receivers[3];
+    INT senderIds[3];
+    INT messages[3];
+    INT bytesReceived;
+    INT message = 0;
+    IPC_MESSAGE* ipcMessage;
+    UINT i;
+
+    for(i = 0; i < 3; i++)
+    {
+        receivers[i] = TestpCreateTask(HighestUserPriority, g_receiverStacks[i]);
+    }
+
+    bwprintf(BWCOM2, "Timing out \r\n");
+
+    T_ASSERT(RT_SUCCESS(IpcReceive(receivers[0], &senderIds[0], &messages[0], sizeof(messages[0]), &bytesReceived)));
+    ClockTimeoutReceive(receivers[0], ClockGetTicks() + 2);
+
+    ClockTick();
+    T_ASSERT(SendBlockedState == receivers[0]->state);
+    T_ASSERT(receivers[0]->timeoutPending);
+
+    ClockTick();
+    T_ASSERT(ReadyState == receivers[0]->state);
+    T_ASSERT(!receivers[0]->timeoutPending);
+    TestpRun(receivers[0]);
+
+    bwprintf(BWCOM2, "Sending before the timeout \r\n");
+
+    T_ASSERT(RT_SUCCESS(IpcReceive(receivers[1], &senderIds[1], &messages[1], sizeof(messages[1]), &bytesReceived)));
+    ClockTimeoutReceive(receivers[1], ClockGetTicks() + 1);
+
+    T_ASSERT(RT_SUCCESS(IpcSend(sender, receivers[1], &message, sizeof(message), NULL, 0)));
+    T_ASSERT(ReadyState == receivers[1]->state);
+    T_ASSERT(!receivers[1]->timeoutPending);
+    T_ASSERT(sender->taskId == senderIds[1]);
+
+    TestpRun(receivers[1]);
+    T_ASSERT(RT_SUCCESS(IpcReply(receivers[1], sender, NULL, 0)));
+    TestpRun(sender);
+
+    // The cancelled timeout doesn't wake the receiver a second time
+    ClockTick();
+    T_ASSERT(RunningState == receivers[1]->state);
+
+    bwprintf(BWCOM2, "Posting before the timeout \r\n");
+
+    T_ASSERT(RT_SUCCESS(IpcReceive(receivers[2], &senderIds[2], &messages[2], sizeof(messages[2]), &bytesReceived)));
+    ClockTimeoutReceive(receivers[2], ClockGetTicks() + 1);
+
+    T_ASSERT(RT_SUCCESS(IpcCreateMessage(sender, receivers[2]->taskId, &message, sizeof(message), &ipcMessage)));
+    T_ASSERT(RT_SUCCESS(IpcPostMessage(ipcMessage)));
+    T_ASSERT(ReadyState == receivers[2]->state);
+    T_ASSERT(!receivers[2]->timeoutPending);
+    T_ASSERT(sender->taskId == senderIds[2]);
+
+    TestpRun(receivers[2]);
+
+    ClockTick();
+    T_ASSERT(RunningState == receivers[2]->state);
+
+    bwprintf(BWCOM2, "Timing out in deadline order \r\n");
+
+    for(i = 0; i < 3; i++)
+    {
+        T_ASSERT(RT_SUCCESS(IpcReceive(receivers[i], &senderIds[i], &messages[i], sizeof(messages[i]), &bytesReceived)));
+    }
+
+    // Tasks with the same deadline time out in the order they started waiting
+    ClockTimeoutReceive(receivers[0], ClockGetTicks() + 3);
+    ClockTimeoutReceive(receivers[1], ClockGetTicks() + 1);
+    ClockTimeoutReceive(receivers[2], ClockGetTicks() + 3);
+
+    ClockTick();
+    T_ASSERT(ReadyState == receivers[1]->state);
+    T_ASSERT(SendBlockedState == receivers[0]->state);
+    T_ASSERT(SendBlockedState == receivers[2]->state);
+    TestpRun(receivers[1]);
+
+    ClockTick();
+    T_ASSERT(SendBlockedState == receivers[0]->state);
+    T_ASSERT(SendBlockedState == receivers[2]->state);
+
+    ClockTick();
+    TestpRun(receivers[0]);
+    TestpRun(receivers[2]);
+}
+
+static
+INT
+TestpPostUntilFull
+    (
+        IN TASK_DESCRIPTOR* from,
+        IN TASK_DESCRIPTOR* to
+    )
+{
+    IPC_MESSAGE* ipcMessage;
+    INT posted = 0;
+
+    while(RT_SUCCESS(IpcCreateMessage(from, to->taskId, &posted, sizeof(posted), &ipcMessage)))
+    {
+        T_ASSERT(RT_SUCCESS(IpcPostMessage(ipcMessage)));
+        posted++;
+    }
+
+    return posted;
+}
+
+static
+VOID
+TestpPostedMessages
+    (
+        VOID
+    )
+{
+    TASK_DESCRIPTOR* poster = TestpCreateTask(HighestUserPriority, g_posterStack);
+    TASK_DESCRIPTOR* receiver = TestpCreateTask(HighestUserPriority, g_postReceiverStacks[0]);
+    TASK_DESCRIPTOR* otherReceiver = TestpCreateTask(HighestUserPriority, g_postReceiverStacks[1]);
+    IPC_MESSAGE* ipcMessage;
+    INT senderId;
+    INT message;
+    INT bytesReceived;
+    INT i;
+
+    bwprintf(BWCOM2, "Filling a message queue \r\n");
+
+    for(i = 0; i < MAX_POSTED_MESSAGES; i++)
+    {
+        T_ASSERT(!IpcIsMessageQueueFull(receiver));
+        T_ASSERT(RT_SUCCESS(IpcCreateMessage(poster, receiver->taskId, &i, sizeof(i), &ipcMessage)));
+        T_ASSERT(RT_SUCCESS(IpcPostMessage(ipcMessage)));
+        T_ASSERT(i + 1 == receiver->messageCount);
+    }
+
+    T_ASSERT(IpcIsMessageQueueFull(receiver));
+
+    // Receiving one makes room for another
+    T_ASSERT(RT_SUCCESS(IpcReceive(receiver, &senderId, &message, sizeof(message), &bytesReceived)));
+    T_ASSERT(poster->taskId == senderId);
+    T_ASSERT(sizeof(message) == bytesReceived);
+    T_ASSERT(0 == message);
+    T_ASSERT(MAX_POSTED_MESSAGES - 1 == receiver->messageCount);
+    T_ASSERT(!IpcIsMessageQueueFull(receiver));
+
+    bwprintf(BWCOM2, "Running out of messages \r\n");
+
+    // Nothing holds the other receiver to the queue limit, so the pool runs dry
+    T_ASSERT(IPC_NUM_MESSAGES - (MAX_POSTED_MESSAGES - 1) == TestpPostUntilFull(poster, otherReceiver));
+    T_ASSERT(STATUS_BUFFER_TOO_SMALL == IpcCreateMessage(poster, receiver->taskId, &message, sizeof(message), &ipcMessage));
+
+    bwprintf(BWCOM2, "Exitting with messages waiting \r\n");
+
+    receiver->state = ZombieState;
+    IpcDrainMailbox(receiver);
+    T_ASSERT(0 == receiver->messageCount);
+    T_ASSERT(NULL == receiver->messageHead);
+
+    otherReceiver->state = ZombieState;
+    IpcDrainMailbox(otherReceiver);
+    T_ASSERT(0 == otherReceiver->messageCount);
+
+    // Every message is back in the pool
+    otherReceiver->state = ReadyState;
+    T_ASSERT(IPC_NUM_MESSAGES == TestpPostUntilFull(poster, otherReceiver));
+    IpcDrainMailbox(otherReceiver);
+}
+
+INT
+main
+    (
+        VOID
+    )
+{
+    TASK_DESCRIPTOR* server;
+    TASK_DESCRIPTOR* client;
+    TASK_DESCRIPTOR* otherClient;
+    INT senderId;
+    INT message = 0;
+    INT bytesReceived;
+
+    bwsetfifo(BWCOM2, OFF);
+    bwsetspeed(BWCOM2, 115200);
+
+    T_ASSERT(RT_SUCCESS(TaskDescriptorInit()));
+    SchedulerInit();
+    ClockInit();
+    IpcInit();
+
+    server = TestpCreateTask(LowestUserPriority, g_serverStack);
+    client = TestpCreateTask(HighestUserPriority, g_clientStack);
+    otherClient = TestpCreateTask(HighestUserPriority, g_otherClientStack);
+
+    IpcEnablePriorityInheritance(server);
+
+    T_ASSERT(RT_SUCCESS(SchedulerAddTask(server)));
+
+    bwprintf(BWCOM2, "Sending to a waiting server \r\n");
+
+    TestpRun(server);
+    T_ASSERT(RT_SUCCESS(IpcReceive(server, &senderId, &message, sizeof(message), &bytesReceived)));
+    T_ASSERT(SendBlockedState == server->state);
+
+    T_ASSERT(RT_SUCCESS(SchedulerAddTask(client)));
+
+    TestpRun(client);
+    T_ASSERT(RT_SUCCESS(IpcSend(client, server, &message, sizeof(message), NULL, 0)));
+    T_ASSERT(ReplyBlockedState == client->state);
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    TestpRun(server);
+    T_ASSERT(client->taskId == senderId);
+    T_ASSERT(RT_SUCCESS(IpcReply(server, client, NULL, 0)));
+    T_ASSERT(LowestUserPriority == server->priority);
+
+    // The client outranks the server again
+    server->state = ReadyState;
+    TestpRun(client);
+
+    bwprintf(BWCOM2, "Sending to a busy server \r\n");
+
+    // The server moves up the ready queue while the client waits on it
+    T_ASSERT(RT_SUCCESS(IpcSend(client, server, &message, sizeof(message), NULL, 0)));
+    T_ASSERT(ReceiveBlockedState == client->state);
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    TestpRun(server);
+    T_ASSERT(RT_SUCCESS(IpcReceive(server, &senderId, &message, sizeof(message), &bytesReceived)));
+    T_ASSERT(client->taskId == senderId);
+    T_ASSERT(ReplyBlockedState == client->state);
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    bwprintf(BWCOM2, "Replying from the wrong task \r\n");
+
+    // The client is waiting on the server, not on anyone else
+    T_ASSERT(STATUS_INVALID_STATE == IpcReply(otherClient, client, NULL, 0));
+    T_ASSERT(ReplyBlockedState == client->state);
+    T_ASSERT(server == client->server);
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    bwprintf(BWCOM2, "Exitting before replying \r\n");
+
+    // The client gave its priority to a task that is gone, and nobody
+    // is left to reply to it
+    server->state = ZombieState;
+    IpcDrainMailbox(server);
+    T_ASSERT(NULL == client->server);
+    T_ASSERT(0 == server->clientPriorities);
+    T_ASSERT(ReadyState == client->state);
+
+    // Bring the slot back as a new server with a client of its own
+    server->state = RunningState;
+    server->priority = LowestUserPriority;
+    IpcInitializeMailbox(server);
+
+    T_ASSERT(RT_SUCCESS(IpcReceive(server, &senderId, &message, sizeof(message), &bytesReceived)));
+
+    TestpRun(client);
+    T_ASSERT(RT_SUCCESS(SchedulerAddTask(otherClient)));
+
+    TestpRun(otherClient);
+    T_ASSERT(RT_SUCCESS(IpcSend(otherClient, server, &message, sizeof(message), NULL, 0)));
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    // The new server can't reply to the first client
+    TestpRun(server);
+    T_ASSERT(STATUS_INVALID_STATE == IpcReply(server, client, NULL, 0));
+    T_ASSERT(HighestUserPriority == server->priority);
+
+    T_ASSERT(RT_SUCCESS(IpcReply(server, otherClient, NULL, 0)));
+    T_ASSERT(LowestUserPriority == server->priority);
+
+    // Let the last client finish so the ready queue starts out empty
+    TestpRun(otherClient);
+    otherClient->state = ZombieState;
+
+    TestpTimeouts();
+    TestpPostedMessages();
+
+    bwprintf(BWCOM2, "IPC exitting \r\n");
+
+    return STATUS_SUCCESS;
+}
@@ -15,6 +15,7 @@ main
     TASK_DESCRIPTOR lowPriorityTask2;
     TASK_DESCRIPTOR highPriorityTask1;
     TASK_DESCRIPTOR highPriorityTask2;
+    TASK_DESCRIPTOR inheritingTask;
     TASK_DESCRIPTOR* nextTask;
     RT_STATUS status;
 
@@ -34,6 +35,10 @@ main
     highPriorityTask2.state = ReadyState;
     highPriorityTask2.priority = HighestUserPriority;
 
+    inheritingTask.taskId = 5;
+    inheritingTask.state = ReadyState;
+    inheritingTask.priority = LowestUserPriority;
+
     bwsetfifo(BWCOM2, OFF);
     bwsetspeed(BWCOM2, 115200);
 
@@ -134,7 +139,45 @@ main
     status = SchedulerGetNextTask(&nextTask);
     T_ASSERT(STATUS_NOT_FOUND == status);
 
+    bwprintf(BWCOM2, "Changing priorities \r\n");
+    lowPriorityTask1.state = ReadyState;
+
+    status = SchedulerAddTask(&lowPriorityTask1);
+    T_ASSERT(RT_SUCCESS(status));
+
+    status = SchedulerAddTask(&inheritingTask);
+    T_ASSERT(RT_SUCCESS(status));
+
+    // Moves the waiting task ahead of lp1
+    SchedulerSetPriority(&inheritingTask, HighestUserPriority);
+
+    status = SchedulerGetNextTask(&nextTask);
+    bwprintf(BWCOM2, "Got task %d \r\n", nextTask->taskId);
+    T_ASSERT(RT_SUCCESS(status));
+    T_ASSERT(nextTask->taskId == 5);
+
+    // Drops the running task back to lp1's priority
+    SchedulerSetPriority(&inheritingTask, LowestUserPriority);
+
+    status = SchedulerGetNextTask(&nextTask);
+    bwprintf(BWCOM2, "Got task %d \r\n", nextTask->taskId);
+    T_ASSERT(RT_SUCCESS(status));
+    T_ASSERT(nextTask->taskId == 1);
+
+    bwprintf(BWCOM2, "Exitting lp1 \r\n");
+    lowPriorityTask1.state = ZombieState;
+
+    status = SchedulerGetNextTask(&nextTask);
+    bwprintf(BWCOM2, "Got task %d \r\n", nextTask->taskId);
+    T_ASSERT(RT_SUCCESS(status));
+    T_ASSERT(nextTask->taskId == 5);
+
+    inheritingTask.state = ZombieState;
+
+    status = SchedulerGetNextTask(&nextTask);
+    T_ASSERT(STATUS_NOT_FOUND == status);
+
     bwprintf(BWCOM2, "Scheduler exitting \r\n");
 
-    return status;
+    return STATUS_SUCCESS;
 }
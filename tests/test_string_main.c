@@ -289,6 +289,65 @@ void test_string_format_leading() {
     T_ASSERT(buffer[4] == '\0');
 }
 
+void test_memcpy() {
+    unsigned int words_src[40];
+    unsigned int words_dest[40];
+    char* src = (char*) words_src;
+    char* dest = (char*) words_dest;
+    int src_offset;
+    int dest_offset;
+    int bytes;
+    int i;
+
+    for(i = 0; i < sizeof(words_src); i++) {
+        src[i] = (char) i;
+    }
+
+    // Every alignment combination, across the head/block/tail boundaries
+    for(src_offset = 0; src_offset < 4; src_offset++) {
+        for(dest_offset = 0; dest_offset < 4; dest_offset++) {
+            for(bytes = 0; bytes < 140; bytes++) {
+                RtMemset(dest, sizeof(words_dest), 0x55);
+                RtMemcpy(dest + dest_offset, src + src_offset, bytes);
+
+                for(i = 0; i < sizeof(words_dest); i++) {
+                    if(i < dest_offset || i >= dest_offset + bytes) {
+                        T_ASSERT(dest[i] == 0x55);
+                    } else {
+                        T_ASSERT(dest[i] == (char) (i - dest_offset + src_offset));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void test_memset() {
+    unsigned int words[40];
+    char* buffer = (char*) words;
+    int offset;
+    int bytes;
+    int i;
+
+    for(offset = 0; offset < 4; offset++) {
+        for(bytes = 0; bytes < 140; bytes++) {
+            for(i = 0; i < sizeof(words); i++) {
+                buffer[i] = 0x55;
+            }
+
+            RtMemset(buffer + offset, bytes, (char) 0xA5);
+
+            for(i = 0; i < sizeof(words); i++) {
+                if(i < offset || i >= offset + bytes) {
+                    T_ASSERT(buffer[i] == 0x55);
+                } else {
+                    T_ASSERT(buffer[i] == (char) 0xA5);
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
 
     test_string_cmp();
@@ -300,6 +359,8 @@ int main(int argc, char* argv[]) {
     test_string_format_string();
     test_string_format_hex();
     test_string_format_leading();
+    test_memcpy();
+    test_memset();
 
     return STATUS_SUCCESS;
 }
@@ -0,0 +1,148 @@
+#include <bwio/bwio.h>
+#include <rtosc/assert.h>
+#include <rtosc/string.h>
+#include <rt.h>
+#include <rtos.h>
+#include "scheduler.h"
+#include "task.h"
+#include "topic.h"
+
+static UINT g_subscriberStack[64];
+static UINT g_publisherStack[64];
+
+static
+VOID
+TestpInitTask
+    (
+        IN TASK_DESCRIPTOR* td,
+        IN INT taskId,
+        IN UINT* stack
+    )
+{
+    td->taskId = taskId;
+    td->state = RunningState;
+    td->priority = LowestUserPriority;
+    td->stackPointer = &stack[32];
+}
+
+static
+INT
+TestpPublish
+    (
+        IN TASK_DESCRIPTOR* publisher,
+        IN INT topic,
+        IN INT value
+    )
+{
+    INT subscribersWoken;
+
+    T_ASSERT(RT_SUCCESS(TopicPublish(publisher, topic, &value, sizeof(value), &subscribersWoken)));
+
+    return subscribersWoken;
+}
+
+INT
+main
+    (
+        VOID
+    )
+{
+    TASK_DESCRIPTOR subscriber;
+    TASK_DESCRIPTOR lateSubscriber;
+    TASK_DESCRIPTOR publisher;
+    TASK_DESCRIPTOR* nextTask;
+    UCHAR longMessage[MAX_BUFFERED_TOPIC_MESSAGE_LENGTH + 1];
+    INT topic;
+    INT value;
+    INT bytesReceived;
+
+    bwsetfifo(BWCOM2, OFF);
+    bwsetspeed(BWCOM2, 115200);
+
+    SchedulerInit();
+    TopicInit();
+
+    TestpInitTask(&subscriber, 1, g_subscriberStack);
+    TestpInitTask(&publisher, 2, g_publisherStack);
+
+    T_ASSERT(RT_SUCCESS(TopicCreate(&topic)));
+
+    bwprintf(BWCOM2, "Subscribing before a publish \r\n");
+
+    // Nothing has been published yet, so the subscriber waits
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&subscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(SubscribeBlockedState == subscriber.state);
+
+    T_ASSERT(1 == TestpPublish(&publisher, topic, 1));
+    T_ASSERT(ReadyState == subscriber.state);
+    T_ASSERT(1 == value);
+
+    // The kernel marks the task it picks as running
+    T_ASSERT(RT_SUCCESS(SchedulerGetNextTask(&nextTask)));
+    T_ASSERT(&subscriber == nextTask);
+    subscriber.state = RunningState;
+
+    bwprintf(BWCOM2, "Catching up on missed publishes \r\n");
+
+    // The subscriber is busy, so nobody is woken
+    T_ASSERT(0 == TestpPublish(&publisher, topic, 2));
+    T_ASSERT(0 == TestpPublish(&publisher, topic, 3));
+
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&subscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(RunningState == subscriber.state);
+    T_ASSERT(sizeof(value) == bytesReceived);
+    T_ASSERT(2 == value);
+
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&subscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(RunningState == subscriber.state);
+    T_ASSERT(3 == value);
+
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&subscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(SubscribeBlockedState == subscriber.state);
+
+    T_ASSERT(1 == TestpPublish(&publisher, topic, 4));
+    T_ASSERT(4 == value);
+
+    T_ASSERT(RT_SUCCESS(SchedulerGetNextTask(&nextTask)));
+    T_ASSERT(&subscriber == nextTask);
+    subscriber.state = RunningState;
+
+    bwprintf(BWCOM2, "Falling too far behind \r\n");
+
+    for(INT i = 0; i < TOPIC_BACKLOG_LENGTH + 4; i++)
+    {
+        T_ASSERT(0 == TestpPublish(&publisher, topic, 5 + i));
+    }
+
+    // Only the last TOPIC_BACKLOG_LENGTH are still held
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&subscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(RunningState == subscriber.state);
+    T_ASSERT(5 + 4 == value);
+
+    bwprintf(BWCOM2, "Subscribing late \r\n");
+
+    // A new subscriber doesn't see anything from before it subscribed
+    TestpInitTask(&lateSubscriber, 1 + NUM_TASKS, g_subscriberStack);
+
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&lateSubscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(SubscribeBlockedState == lateSubscriber.state);
+
+    bwprintf(BWCOM2, "Publishing a long message \r\n");
+
+    RtMemset(longMessage, sizeof(longMessage), 0);
+    longMessage[0] = 42;
+
+    T_ASSERT(RT_SUCCESS(TopicPublish(&publisher, topic, longMessage, sizeof(longMessage), &bytesReceived)));
+    T_ASSERT(1 == bytesReceived);
+    T_ASSERT(42 == value);
+
+    // Long messages aren't held, so the next subscribe waits
+    TestpInitTask(&lateSubscriber, 1 + NUM_TASKS, g_subscriberStack);
+
+    T_ASSERT(RT_SUCCESS(TopicSubscribe(&lateSubscriber, topic, &value, sizeof(value), &bytesReceived)));
+    T_ASSERT(SubscribeBlockedState == lateSubscriber.state);
+
+    bwprintf(BWCOM2, "Topic exitting \r\n");
+
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Turns a kernel trace dump captured from COM2 in to Chrome trace JSON.
+
+Usage: trace_decode.py capture.log > trace.json
+
+Open the result in chrome://tracing or https://ui.perfetto.dev.  Every
+task gets its own row.  Time spent running and inside system calls shows
+up as slices, while task creation, interrupts and event wakeups show up
+as instant events.  Only the last dump in the capture is decoded.
+"""
+
+import json
+import sys
+
+# Timer3 runs at 508 khz and counts down
+TICKS_PER_US = 0.508
+
+# Must match TRACE_EVENT in src/kernel/trace.h
+TASK_CREATE = 1
+CONTEXT_SWITCH = 2
+SYSTEM_CALL_ENTER = 3
+SYSTEM_CALL_EXIT = 4
+INTERRUPT = 5
+EVENT_WAKEUP = 6
+
+# Must match SYSTEM_CALL_NUMBER in inc/rtos/rtkernel.h
+SYSTEM_CALLS = [
+    "Create",
+    "MyTid",
+    "MyParentTid",
+    "Pass",
+    "Exit",
+    "Send",
+    "Receive",
+    "Reply",
+    "AwaitEvent",
+    "QueryPerformance",
+    "CreateEx",
+    "DumpKernelTrace",
+    "QueryEventLatency",
+    "DelayedSend",
+    "SendAt",
+    "ReceiveTimeout",
+    "Post",
+    "CreateTopic",
+    "Subscribe",
+    "Publish",
+    "AwaitEventData",
+    "QueryPerformanceAll",
+    "EnablePriorityInheritance",
+    "CreateWithArg",
+    "CreateExWithArg",
+    "ReadKernelTrace",
+    "ReceiveUntil",
+]
+
+# Must match EVENT in inc/rtos/rtkernel.h
+EVENTS = [
+    "ClockEvent",
+    "UartCom1ReceiveEvent",
+    "UartCom1TransmitEvent",
+    "UartCom2ReceiveEvent",
+    "UartCom2TransmitEvent",
+]
+
+KERNEL_ROW = -1
+
+
+def read_records(lines):
+    last = []
+    records = None
+
+    for line in lines:
+        line = line.strip()
+
+        if line.startswith("#TRACE"):
+            records = []
+        elif line.startswith("#END"):
+            if records is not None:
+                last = records
+            records = None
+        elif records is not None and line:
+            fields = line.split()
+
+            if len(fields) == 3:
+                # Other output on COM2 can cut in to a live dump
+                try:
+                    ticks, header, data = (int(field, 16) for field in fields)
+                except ValueError:
+                    continue
+
+                records.append((ticks, header >> 24, header & 0xFFFFFF, data))
+
+    return last
+
+
+def name_of(table, index):
+    return table[index] if index < len(table) else str(index)
+
+
+def decode(records):
+    events = []
+    start = records[0][0] if records else 0
+    running = None
+    entered = {}
+    priorities = {}
+
+    def timestamp(ticks):
+        # Unsigned math takes care of the counter wrapping around
+        return ((start - ticks) & 0xFFFFFFFF) / TICKS_PER_US
+
+    def complete(name, task, begin, end, args=None):
+        events.append({
+            "name": name,
+            "ph": "X",
+            "pid": 0,
+            "tid": task,
+            "ts": begin,
+            "dur": max(end - begin, 0),
+            "args": args or {},
+        })
+
+    def instant(name, task, ts, args=None):
+        events.append({
+            "name": name,
+            "ph": "i",
+            "s": "t",
+            "pid": 0,
+            "tid": task,
+            "ts": ts,
+            "args": args or {},
+        })
+
+    for ticks, event, task, data in records:
+        ts = timestamp(ticks)
+
+        if event == CONTEXT_SWITCH:
+            running = (task, ts, data)
+            priorities[task] = data
+        elif event == SYSTEM_CALL_ENTER:
+            if running is not None and running[0] == task:
+                complete("running", task, running[1], ts, {"priority": hex(running[2])})
+                running = None
+            entered[task] = ts
+        elif event == SYSTEM_CALL_EXIT:
+            complete(name_of(SYSTEM_CALLS, data), task, entered.pop(task, ts), ts)
+
+            # The kernel resumes a task without a context switch record
+            # when nothing else would run.  A real switch replaces this.
+            running = (task, ts, priorities.get(task, 0))
+        elif event == INTERRUPT:
+            if running is not None and running[0] == task:
+                complete("running", task, running[1], ts, {"priority": hex(running[2])})
+                running = None
+            instant("interrupt", KERNEL_ROW, ts, {"task": task})
+        elif event == EVENT_WAKEUP:
+            instant("wakeup " + name_of(EVENTS, data), task, ts)
+        elif event == TASK_CREATE:
+            instant("created", task, ts, {"parent": data})
+
+    tasks = sorted({record[2] for record in records})
+    metadata = [{"name": "thread_name", "ph": "M", "pid": 0, "tid": KERNEL_ROW,
+                 "args": {"name": "kernel"}}]
+    metadata += [{"name": "thread_name", "ph": "M", "pid": 0, "tid": task,
+                  "args": {"name": "task %d" % task}} for task in tasks]
+
+    return {"traceEvents": metadata + events, "displayTimeUnit": "ms"}
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], errors="replace") as capture:
+            records = read_records(capture)
+    else:
+        records = read_records(sys.stdin)
+
+    if not records:
+        sys.exit("No kernel trace found")
+
+    json.dump(decode(records), sys.stdout)
+
+
+if __name__ == "__main__":
+    main()